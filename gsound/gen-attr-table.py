@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+#
+# gen-attr-table.py
+#
+# Copyright (C) 2026 The GSound Authors
+#
+# This file is free software; you can redistribute it and/or modify it
+# under the terms of the GNU Lesser General Public License as
+# published by the Free Software Foundation; either version 2.1 of the
+# License, or (at your option) any later version.
+#
+# This file is distributed in the hope that it will be useful, but
+# WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+# Lesser General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+# Generates the table of known attribute keys from the GSOUND_ATTR_*
+# definitions in gsound-attr.h, along with a perfect hash mapping each key
+# string to its GSoundAttrKey. The hash is FNV-1a with a seed chosen so
+# that no two keys share a slot; gsound-attr.c must compute it the same way.
+# Slots are taken from the top bits of the hash, as the low bits only depend
+# on the low bits of the seed and so leave few seeds to choose from.
+#
+# The public GSoundAttrKey enum is written out by hand for the docs and
+# introspection, so the table also asserts that each of its values follows
+# the order of the definitions.
+
+import re
+import sys
+
+DEFINE_RE = re.compile(r'^#define\s+GSOUND_ATTR_(\w+)\s+"([^"]+)"', re.M)
+
+MAX_SEED = 1 << 20
+
+
+def fnv1a(key, seed):
+    h = seed
+    for c in key.encode('utf-8'):
+        h ^= c
+        h = (h * 16777619) & 0xffffffff
+    return h
+
+
+def find_seed(keys, shift):
+    for seed in range(0x811c9dc5, 0x811c9dc5 + MAX_SEED):
+        slots = set()
+        for key in keys:
+            slot = fnv1a(key, seed) >> shift
+            if slot in slots:
+                break
+            slots.add(slot)
+        else:
+            return seed
+
+    sys.exit('gen-attr-table.py: no perfect hash for %d keys' % len(keys))
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.exit('usage: gen-attr-table.py gsound-attr.h OUTPUT')
+
+    with open(sys.argv[1], encoding='utf-8') as f:
+        defines = DEFINE_RE.findall(f.read())
+
+    names = [name for name, _ in defines]
+    keys = [key for _, key in defines]
+
+    if len(set(keys)) != len(keys):
+        sys.exit('gen-attr-table.py: duplicate attribute keys')
+
+    # Keep the table sparse enough that a seed is found quickly
+    bits = 1
+    while (1 << bits) < 4 * len(keys):
+        bits += 1
+    shift = 32 - bits
+
+    seed = find_seed(keys, shift)
+    slots = [0] * (1 << bits)
+    for i, key in enumerate(keys):
+        slots[fnv1a(key, seed) >> shift] = i + 1
+
+    out = []
+    out.append('/* Generated by gen-attr-table.py from gsound-attr.h, '
+               'do not edit */')
+    out.append('')
+    out.append('#define GSOUND_ATTR_TABLE_N_KEYS %d' % len(keys))
+    out.append('#define GSOUND_ATTR_TABLE_SEED 0x%08xu' % seed)
+    out.append('#define GSOUND_ATTR_TABLE_SHIFT %d' % shift)
+    out.append('')
+    for i, name in enumerate(names):
+        out.append('G_STATIC_ASSERT (GSOUND_ATTR_KEY_%s == %d);' % (name, i + 1))
+    out.append('')
+    out.append('static const char * const '
+               'gsound_attr_names[GSOUND_ATTR_TABLE_N_KEYS + 1] = {')
+    out.append('  [GSOUND_ATTR_KEY_NONE] = NULL,')
+    for name in names:
+        out.append('  [GSOUND_ATTR_KEY_%s] = GSOUND_ATTR_%s,' % (name, name))
+    out.append('};')
+    out.append('')
+    out.append('/* Key ids by hash slot */')
+    out.append('static const GSoundAttrKey gsound_attr_slots[] = {')
+    for slot in slots:
+        out.append('  GSOUND_ATTR_KEY_%s,' %
+                   (names[slot - 1] if slot else 'NONE'))
+    out.append('};')
+    out.append('')
+
+    with open(sys.argv[2], 'w', encoding='utf-8') as f:
+        f.write('\n'.join(out))
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,35 @@
+/* gsound-adpcm-private.h
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GSOUND_ADPCM_PRIVATE_H
+#define GSOUND_ADPCM_PRIVATE_H
+
+#include "gsound-clip-private.h"
+
+G_BEGIN_DECLS
+
+GBytes *gsound_adpcm_encode (GSoundClip *clip);
+
+void    gsound_adpcm_decode (GBytes     *adpcm,
+                             guint       channels,
+                             gsize       n_frames,
+                             float      *samples);
+
+G_END_DECLS
+
+#endif /* GSOUND_ADPCM_PRIVATE_H */
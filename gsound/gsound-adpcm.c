@@ -0,0 +1,206 @@
+/* gsound-adpcm.c
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* IMA ADPCM, used to keep preloaded clips in memory at four bits per
+ * sample. Samples are coded in blocks of BLOCK_FRAMES frames, each channel
+ * separately: a 4-byte header holding the predictor and step index at the
+ * start of the block, followed by one nibble per frame, low nibble first.
+ * The encoder state carries over from block to block, and the last block
+ * is padded with silence. */
+
+#include "gsound-adpcm-private.h"
+
+#include <math.h>
+
+#define BLOCK_FRAMES 1024
+#define CHANNEL_BLOCK_SIZE (4 + BLOCK_FRAMES / 2)
+
+static const gint16 step_table[89] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41,
+  45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190,
+  209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724,
+  796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272,
+  2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132,
+  7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500,
+  20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const gint8 index_table[16] = {
+  -1, -1, -1, -1, 2, 4, 6, 8,
+  -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+typedef struct
+{
+  int predictor;
+  int index;
+} AdpcmState;
+
+/* Applies @code to @state, returning the new sample */
+static inline int
+adpcm_step (AdpcmState *state,
+            guint       code)
+{
+  int step = step_table[state->index];
+  int diff = step >> 3;
+
+  if (code & 4)
+    diff += step;
+  if (code & 2)
+    diff += step >> 1;
+  if (code & 1)
+    diff += step >> 2;
+
+  state->predictor += code & 8 ? -diff : diff;
+  state->predictor = CLAMP (state->predictor, -32768, 32767);
+  state->index = CLAMP (state->index + index_table[code], 0, 88);
+
+  return state->predictor;
+}
+
+static inline guint
+adpcm_encode_sample (AdpcmState *state,
+                     int         sample)
+{
+  int step = step_table[state->index];
+  int diff = sample - state->predictor;
+  guint code = 0;
+
+  if (diff < 0)
+    {
+      code = 8;
+      diff = -diff;
+    }
+
+  if (diff >= step)
+    {
+      code |= 4;
+      diff -= step;
+    }
+  if (diff >= step >> 1)
+    {
+      code |= 2;
+      diff -= step >> 1;
+    }
+  if (diff >= step >> 2)
+    code |= 1;
+
+  adpcm_step (state, code);
+
+  return code;
+}
+
+static inline int
+float_to_s16 (float sample)
+{
+  return (int) lrintf (CLAMP (sample, -1.0f, 1.0f) * 32767.0f);
+}
+
+/*
+ * gsound_adpcm_encode:
+ * @clip: a #GSoundClip
+ *
+ * Encodes the samples of @clip as IMA ADPCM.
+ *
+ * Returns: (transfer full): the encoded samples
+ */
+GBytes *
+gsound_adpcm_encode (GSoundClip *clip)
+{
+  AdpcmState states[8] = { { 0 } };
+  gsize n_blocks, size, block, i;
+  guint8 *data, *p;
+  guint c;
+
+  g_return_val_if_fail (clip->channels <= G_N_ELEMENTS (states), NULL);
+
+  n_blocks = (clip->n_frames + BLOCK_FRAMES - 1) / BLOCK_FRAMES;
+  size = n_blocks * clip->channels * CHANNEL_BLOCK_SIZE;
+  data = p = g_malloc (size);
+
+  for (block = 0; block < n_blocks; block++)
+    for (c = 0; c < clip->channels; c++)
+      {
+        AdpcmState *state = &states[c];
+        gsize start = block * BLOCK_FRAMES;
+
+        p[0] = state->predictor & 0xff;
+        p[1] = (state->predictor >> 8) & 0xff;
+        p[2] = state->index;
+        p[3] = 0;
+        p += 4;
+
+        for (i = 0; i < BLOCK_FRAMES; i += 2)
+          {
+            int a = 0, b = 0;
+
+            if (start + i < clip->n_frames)
+              a = float_to_s16 (clip->samples[(start + i) * clip->channels + c]);
+            if (start + i + 1 < clip->n_frames)
+              b = float_to_s16 (clip->samples[(start + i + 1) * clip->channels + c]);
+
+            *p = adpcm_encode_sample (state, a);
+            *p++ |= adpcm_encode_sample (state, b) << 4;
+          }
+      }
+
+  return g_bytes_new_take (data, size);
+}
+
+/*
+ * gsound_adpcm_decode:
+ * @adpcm: samples encoded by gsound_adpcm_encode()
+ * @channels: the number of channels of the encoded clip
+ * @n_frames: the number of frames of the encoded clip
+ * @samples: return location for @n_frames interleaved frames
+ *
+ * Decodes the samples of a clip encoded by gsound_adpcm_encode().
+ */
+void
+gsound_adpcm_decode (GBytes *adpcm,
+                     guint   channels,
+                     gsize   n_frames,
+                     float  *samples)
+{
+  const guint8 *p = g_bytes_get_data (adpcm, NULL);
+  gsize start, i;
+  guint c;
+
+  for (start = 0; start < n_frames; start += BLOCK_FRAMES)
+    {
+      gsize n = MIN (BLOCK_FRAMES, n_frames - start);
+
+      for (c = 0; c < channels; c++)
+        {
+          AdpcmState state;
+          float *out = samples + start * channels + c;
+
+          state.predictor = (gint16) (p[0] | (p[1] << 8));
+          state.index = MIN (p[2], 88);
+
+          for (i = 0; i < n; i++)
+            {
+              guint code = (p[4 + i / 2] >> ((i & 1) * 4)) & 0xf;
+
+              out[i * channels] = adpcm_step (&state, code) * (1.0f / 32768.0f);
+            }
+
+          p += CHANNEL_BLOCK_SIZE;
+        }
+    }
+}
@@ -0,0 +1,39 @@
+/* gsound-attr-private.h
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GSOUND_ATTR_PRIVATE_H
+#define GSOUND_ATTR_PRIVATE_H
+
+#include "gsound-attr.h"
+
+G_BEGIN_DECLS
+
+/*
+ * Checks that @value is set and matches the type of the known attribute
+ * @id, or for %GSOUND_ATTR_KEY_NONE that @key is a name libcanberra
+ * accepts, so that bad attributes are rejected before any backend work.
+ * The error names the offending key.
+ */
+gboolean gsound_attr_validate (GSoundAttrKey   id,
+                               const char     *key,
+                               const char     *value,
+                               GError        **error);
+
+G_END_DECLS
+
+#endif /* GSOUND_ATTR_PRIVATE_H */
@@ -0,0 +1,297 @@
+/* gsound-attr.c
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gsound-attr-private.h"
+#include "gsound-context.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "gsound-attr-table.h"
+
+G_STATIC_ASSERT (GSOUND_ATTR_TABLE_N_KEYS + 1 == GSOUND_ATTR_N_KEYS);
+
+typedef enum
+{
+  ATTR_TYPE_STRING = 0,
+  ATTR_TYPE_INT,
+  ATTR_TYPE_UINT,
+  ATTR_TYPE_INT_LIST,
+  ATTR_TYPE_FLOAT,
+  ATTR_TYPE_FRACTION,
+  ATTR_TYPE_BOOLEAN,
+  ATTR_TYPE_CHOICE,
+} AttrType;
+
+typedef struct
+{
+  AttrType            type;
+  const char * const *choices;
+} AttrInfo;
+
+static const char * const cache_control_choices[] = {
+  "permanent", "volatile", "never", NULL
+};
+
+static const char * const force_channel_choices[] = {
+  "mono", "front-left", "front-right", "front-center", "rear-left",
+  "rear-right", "rear-center", "lfe", "front-left-of-center",
+  "front-right-of-center", "side-left", "side-right", "top-center",
+  "top-front-left", "top-front-right", "top-front-center", "top-rear-left",
+  "top-rear-right", "top-rear-center", NULL
+};
+
+static const char * const retrigger_choices[] = {
+  "overlap", "restart", "ignore", "queue", NULL
+};
+
+static const char * const priority_choices[] = {
+  "low", "normal", "high", NULL
+};
+
+static const char * const waveform_choices[] = {
+  "sine", "square", "triangle", "sawtooth", NULL
+};
+
+/* Value types of the known attributes, following the libcanberra property
+ * documentation. Attributes not listed take any string. */
+static const AttrInfo attr_info[GSOUND_ATTR_N_KEYS] = {
+  [GSOUND_ATTR_KEY_EVENT_MOUSE_X] = { ATTR_TYPE_INT },
+  [GSOUND_ATTR_KEY_EVENT_MOUSE_Y] = { ATTR_TYPE_INT },
+  [GSOUND_ATTR_KEY_EVENT_MOUSE_HPOS] = { ATTR_TYPE_FRACTION },
+  [GSOUND_ATTR_KEY_EVENT_MOUSE_VPOS] = { ATTR_TYPE_FRACTION },
+  [GSOUND_ATTR_KEY_EVENT_MOUSE_BUTTON] = { ATTR_TYPE_UINT },
+  [GSOUND_ATTR_KEY_WINDOW_X] = { ATTR_TYPE_INT },
+  [GSOUND_ATTR_KEY_WINDOW_Y] = { ATTR_TYPE_INT },
+  [GSOUND_ATTR_KEY_WINDOW_WIDTH] = { ATTR_TYPE_UINT },
+  [GSOUND_ATTR_KEY_WINDOW_HEIGHT] = { ATTR_TYPE_UINT },
+  [GSOUND_ATTR_KEY_WINDOW_HPOS] = { ATTR_TYPE_FRACTION },
+  [GSOUND_ATTR_KEY_WINDOW_VPOS] = { ATTR_TYPE_FRACTION },
+  [GSOUND_ATTR_KEY_WINDOW_DESKTOP] = { ATTR_TYPE_INT_LIST },
+  [GSOUND_ATTR_KEY_WINDOW_X11_SCREEN] = { ATTR_TYPE_UINT },
+  [GSOUND_ATTR_KEY_WINDOW_X11_MONITOR] = { ATTR_TYPE_UINT },
+  [GSOUND_ATTR_KEY_WINDOW_X11_XID] = { ATTR_TYPE_UINT },
+  [GSOUND_ATTR_KEY_APPLICATION_PROCESS_ID] = { ATTR_TYPE_UINT },
+  [GSOUND_ATTR_KEY_CANBERRA_CACHE_CONTROL] = { ATTR_TYPE_CHOICE, cache_control_choices },
+  [GSOUND_ATTR_KEY_CANBERRA_VOLUME] = { ATTR_TYPE_FLOAT },
+  [GSOUND_ATTR_KEY_CANBERRA_ENABLE] = { ATTR_TYPE_BOOLEAN },
+  [GSOUND_ATTR_KEY_CANBERRA_FORCE_CHANNEL] = { ATTR_TYPE_CHOICE, force_channel_choices },
+  [GSOUND_ATTR_KEY_GSOUND_RETRIGGER] = { ATTR_TYPE_CHOICE, retrigger_choices },
+  [GSOUND_ATTR_KEY_GSOUND_TIMEOUT] = { ATTR_TYPE_UINT },
+  [GSOUND_ATTR_KEY_GSOUND_RENDER_OFFSET] = { ATTR_TYPE_UINT },
+  [GSOUND_ATTR_KEY_GSOUND_RENDER_CANCEL] = { ATTR_TYPE_UINT },
+  [GSOUND_ATTR_KEY_GSOUND_RENDER_FADE_OUT] = { ATTR_TYPE_UINT },
+  [GSOUND_ATTR_KEY_GSOUND_PRIORITY] = { ATTR_TYPE_CHOICE, priority_choices },
+  [GSOUND_ATTR_KEY_GSOUND_TONE_FREQUENCY] = { ATTR_TYPE_FLOAT },
+  [GSOUND_ATTR_KEY_GSOUND_TONE_FREQUENCY_END] = { ATTR_TYPE_FLOAT },
+  [GSOUND_ATTR_KEY_GSOUND_TONE_WAVEFORM] = { ATTR_TYPE_CHOICE, waveform_choices },
+  [GSOUND_ATTR_KEY_GSOUND_TONE_DURATION] = { ATTR_TYPE_UINT },
+  [GSOUND_ATTR_KEY_GSOUND_TONE_ATTACK] = { ATTR_TYPE_UINT },
+  [GSOUND_ATTR_KEY_GSOUND_TONE_RELEASE] = { ATTR_TYPE_UINT },
+};
+
+/* Must match fnv1a() in gen-attr-table.py */
+static inline guint32
+gsound_attr_hash (const char *key)
+{
+  guint32 h = GSOUND_ATTR_TABLE_SEED;
+
+  for (; *key; key++)
+    {
+      h ^= (guint8) *key;
+      h *= 16777619u;
+    }
+
+  return h;
+}
+
+/**
+ * gsound_attr_key_from_string:
+ * @key: an attribute name, such as #GSOUND_ATTR_EVENT_ID
+ *
+ * Looks up the id of the attribute named @key.
+ *
+ * Returns: the #GSoundAttrKey for @key, or %GSOUND_ATTR_KEY_NONE if @key
+ *   is not one of the attributes defined by GSound
+ */
+GSoundAttrKey
+gsound_attr_key_from_string (const char *key)
+{
+  GSoundAttrKey id;
+
+  g_return_val_if_fail (key != NULL, GSOUND_ATTR_KEY_NONE);
+
+  id = gsound_attr_slots[gsound_attr_hash (key) >> GSOUND_ATTR_TABLE_SHIFT];
+
+  if (id != GSOUND_ATTR_KEY_NONE && strcmp (gsound_attr_names[id], key) == 0)
+    return id;
+
+  return GSOUND_ATTR_KEY_NONE;
+}
+
+/**
+ * gsound_attr_key_to_string:
+ * @key: a #GSoundAttrKey
+ *
+ * Gets the name of the attribute identified by @key. The same string is
+ * returned for every call with the same @key.
+ *
+ * Returns: (nullable): the attribute name, or %NULL for
+ *   %GSOUND_ATTR_KEY_NONE
+ */
+const char *
+gsound_attr_key_to_string (GSoundAttrKey key)
+{
+  g_return_val_if_fail (key < GSOUND_ATTR_N_KEYS, NULL);
+
+  return gsound_attr_names[key];
+}
+
+static gboolean
+parse_int (const char *value)
+{
+  return g_ascii_string_to_signed (value, 10, G_MININT, G_MAXINT, NULL, NULL);
+}
+
+static gboolean
+parse_float (const char *value,
+             double     *d)
+{
+  char *end;
+
+  *d = g_ascii_strtod (value, &end);
+
+  return end != value && *end == '\0' && isfinite (*d);
+}
+
+static gboolean
+check_value (const AttrInfo *info,
+             const char     *value,
+             const char    **expected)
+{
+  double d;
+  guint i;
+
+  switch (info->type)
+    {
+    case ATTR_TYPE_STRING:
+      return TRUE;
+
+    case ATTR_TYPE_INT:
+      *expected = "an integer";
+      return parse_int (value);
+
+    case ATTR_TYPE_UINT:
+      *expected = "a non-negative integer";
+      return g_ascii_string_to_unsigned (value, 10, 0, G_MAXUINT, NULL, NULL);
+
+    case ATTR_TYPE_INT_LIST:
+      {
+        char **items = g_strsplit (value, ",", -1);
+        gboolean ok = items[0] != NULL;
+
+        *expected = "a comma-separated list of integers";
+        for (i = 0; ok && items[i]; i++)
+          ok = parse_int (items[i]);
+
+        g_strfreev (items);
+        return ok;
+      }
+
+    case ATTR_TYPE_FLOAT:
+      *expected = "a number";
+      return parse_float (value, &d);
+
+    case ATTR_TYPE_FRACTION:
+      *expected = "a number between 0 and 1";
+      return parse_float (value, &d) && d >= 0.0 && d <= 1.0;
+
+    case ATTR_TYPE_BOOLEAN:
+      *expected = "“0” or “1”";
+      return strcmp (value, "0") == 0 || strcmp (value, "1") == 0;
+
+    case ATTR_TYPE_CHOICE:
+      for (i = 0; info->choices[i]; i++)
+        if (strcmp (value, info->choices[i]) == 0)
+          return TRUE;
+      return FALSE;
+
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+/* As ca_proplist_sets() requires */
+static gboolean
+key_is_valid (const char *key)
+{
+  const char *p;
+
+  if (!*key)
+    return FALSE;
+
+  for (p = key; *p; p++)
+    if (!g_ascii_isalnum (*p) && *p != '.' && *p != '_' && *p != '-')
+      return FALSE;
+
+  return TRUE;
+}
+
+gboolean
+gsound_attr_validate (GSoundAttrKey   id,
+                      const char     *key,
+                      const char     *value,
+                      GError        **error)
+{
+  const AttrInfo *info = &attr_info[id];
+  const char *expected = NULL;
+
+  /* A hash table of attributes may map a key to NULL */
+  if (!value)
+    {
+      g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_INVALID,
+                   "No value for attribute “%s”", key);
+      return FALSE;
+    }
+
+  if (id == GSOUND_ATTR_KEY_NONE && !key_is_valid (key))
+    {
+      g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_INVALID,
+                   "Invalid attribute name “%s”", key);
+      return FALSE;
+    }
+
+  if (G_LIKELY (check_value (info, value, &expected)))
+    return TRUE;
+
+  if (info->type == ATTR_TYPE_CHOICE)
+    {
+      char *choices = g_strjoinv ("”, “", (char **) info->choices);
+
+      g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_INVALID,
+                   "Invalid value “%s” for attribute “%s”, expected one of “%s”",
+                   value, key, choices);
+      g_free (choices);
+    }
+  else
+    g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_INVALID,
+                 "Invalid value “%s” for attribute “%s”, expected %s",
+                 value, key, expected);
+
+  return FALSE;
+}
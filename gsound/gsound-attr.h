@@ -35,6 +35,12 @@ G_BEGIN_DECLS
  * 
  * Attributes which can be applied to a #GSoundContext or passed to one of
  * the `play()` or `cache()` methods.
+ *
+ * Values of attributes with a defined format, such as numbers for
+ * #GSOUND_ATTR_CANBERRA_VOLUME or the channel names of
+ * #GSOUND_ATTR_CANBERRA_FORCE_CHANNEL, are checked before anything is sent
+ * to the sound server. A bad value fails the call with
+ * %GSOUND_ERROR_INVALID and a message naming the attribute.
  */
 
 /**
@@ -131,6 +137,9 @@ G_BEGIN_DECLS
  * position of the mouse cursor as fractional value between 0 and 1,
  * formatted as string, 0 reflecting the left side of the screen, 1
  * the right side.
+ *
+ * gsound_context_render() pans sounds between the left and right channels
+ * by this position.
  */
 #define GSOUND_ATTR_EVENT_MOUSE_HPOS                   "event.mouse.hpos"
 
@@ -228,6 +237,9 @@ G_BEGIN_DECLS
  * position of the center of the window as fractional value between 0
  * and 1, formatted as string, 0 reflecting the left side of the
  * screen, 1 the right side.
+ *
+ * gsound_context_render() pans sounds between the left and right channels
+ * by this position, unless #GSOUND_ATTR_EVENT_MOUSE_HPOS is also set.
  */
 #define GSOUND_ATTR_WINDOW_HPOS                        "window.hpos"
 
@@ -460,7 +472,314 @@ G_BEGIN_DECLS
  */
 #define GSOUND_ATTR_CANBERRA_FORCE_CHANNEL            "canberra.force_channel"
 
+/**
+ * GSOUND_ATTR_GSOUND_RETRIGGER:
+ *
+ * A special attribute that controls what happens when a sound is played
+ * with the same #GSOUND_ATTR_EVENT_ID as one which is still playing on the
+ * same #GSoundContext. One of "overlap", "restart", "ignore" or "queue".
+ * "overlap" plays both instances at once, and is the default. "restart"
+ * cancels the instances already playing before starting the new one.
+ * "ignore" drops the new request while the event is playing; a
+ * gsound_context_play_full() callback will receive #GSOUND_ERROR_CANCELED.
+ * "queue" starts the new instance once the earlier ones have finished.
+ *
+ * This attribute is handled by GSound and never passed to the sound server.
+ */
+#define GSOUND_ATTR_GSOUND_RETRIGGER                   "gsound.retrigger"
+
+/**
+ * GSOUND_ATTR_GSOUND_GROUP:
+ *
+ * A special attribute naming the mix group this sound belongs to, for
+ * example "alerts", "feedback" or "ambient". Groups share a volume
+ * adjustment, a voice limit and ducking rules, configured with
+ * gsound_context_set_group_volume(), gsound_context_set_group_max_voices()
+ * and gsound_context_set_group_ducking().
+ *
+ * This attribute is handled by GSound and never passed to the sound server.
+ */
+#define GSOUND_ATTR_GSOUND_GROUP                       "gsound.group"
+
+/**
+ * GSOUND_ATTR_GSOUND_TAG:
+ *
+ * A special attribute holding an arbitrary application-defined tag, which
+ * can later be passed to gsound_context_cancel_matching() to cancel all
+ * sounds played with the same tag.
+ *
+ * This attribute is handled by GSound and never passed to the sound server.
+ */
+#define GSOUND_ATTR_GSOUND_TAG                         "gsound.tag"
+
+/**
+ * GSOUND_ATTR_GSOUND_TIMEOUT:
+ *
+ * A special attribute that overrides #GSoundContext:timeout for one sound.
+ * An unsigned integer time in milliseconds, or "0" to wait forever.
+ *
+ * This attribute is handled by GSound and never passed to the sound server.
+ */
+#define GSOUND_ATTR_GSOUND_TIMEOUT                     "gsound.timeout"
+
+/**
+ * GSOUND_ATTR_GSOUND_RENDER_OFFSET:
+ *
+ * A special attribute used by gsound_context_render() to position a sound
+ * on the render timeline. An unsigned integer offset in milliseconds from
+ * the start of the rendered output, of at most 600000 (ten minutes).
+ * Defaults to 0.
+ *
+ * This attribute is ignored when playing sounds.
+ */
+#define GSOUND_ATTR_GSOUND_RENDER_OFFSET               "gsound.render.offset"
 
+/**
+ * GSOUND_ATTR_GSOUND_RENDER_CANCEL:
+ *
+ * A special attribute used by gsound_context_render() to cancel a sound
+ * part way through. An unsigned integer time in milliseconds from the start
+ * of the rendered output, of at most 600000, at which the sound is cancelled
+ * and starts fading out. By default sounds play to the end.
+ *
+ * This attribute is ignored when playing sounds.
+ */
+#define GSOUND_ATTR_GSOUND_RENDER_CANCEL               "gsound.render.cancel"
+
+/**
+ * GSOUND_ATTR_GSOUND_RENDER_FADE_OUT:
+ *
+ * A special attribute used by gsound_context_render() which overrides
+ * #GSoundContext:render-fade-out for one sound. An unsigned integer
+ * duration in milliseconds.
+ *
+ * This attribute is ignored when playing sounds.
+ */
+#define GSOUND_ATTR_GSOUND_RENDER_FADE_OUT             "gsound.render.fade-out"
+
+/**
+ * GSOUND_ATTR_GSOUND_PRIORITY:
+ *
+ * A special attribute giving the importance of a sound, one of "low",
+ * "normal" (the default) or "high". When the sound server falls behind,
+ * GSound drops low priority sounds first, and normal ones if things get
+ * worse, but always plays those with high priority; see
+ * gsound_context_set_qos_thresholds(). Use "low" for non-essential sounds
+ * such as input feedback, and "high" for alerts.
+ *
+ * This attribute is handled by GSound and never passed to the sound server.
+ */
+#define GSOUND_ATTR_GSOUND_PRIORITY                    "gsound.priority"
+
+/**
+ * GSOUND_ATTR_GSOUND_TONE_FREQUENCY:
+ *
+ * A special attribute which makes GSound synthesize the sound instead of
+ * loading it from a file or the sound theme. The frequency of the tone in
+ * Hz, between 20 and 20000. The remaining "gsound.tone" attributes describe
+ * the tone further.
+ *
+ * Tones are generated once and then reused, so that simple beeps and
+ * chirps need no theme lookup and no sound files. This attribute is ignored
+ * if #GSOUND_ATTR_MEDIA_FILENAME is set.
+ *
+ * This attribute is handled by GSound and never passed to the sound server.
+ */
+#define GSOUND_ATTR_GSOUND_TONE_FREQUENCY              "gsound.tone.frequency"
+
+/**
+ * GSOUND_ATTR_GSOUND_TONE_FREQUENCY_END:
+ *
+ * A special attribute which turns a tone into a chirp, sweeping linearly
+ * from #GSOUND_ATTR_GSOUND_TONE_FREQUENCY to this frequency in Hz over the
+ * duration of the tone. Defaults to a constant frequency.
+ *
+ * This attribute is handled by GSound and never passed to the sound server.
+ */
+#define GSOUND_ATTR_GSOUND_TONE_FREQUENCY_END          "gsound.tone.frequency-end"
+
+/**
+ * GSOUND_ATTR_GSOUND_TONE_WAVEFORM:
+ *
+ * A special attribute giving the waveform of a tone, one of "sine" (the
+ * default), "square", "triangle" or "sawtooth".
+ *
+ * This attribute is handled by GSound and never passed to the sound server.
+ */
+#define GSOUND_ATTR_GSOUND_TONE_WAVEFORM               "gsound.tone.waveform"
+
+/**
+ * GSOUND_ATTR_GSOUND_TONE_DURATION:
+ *
+ * A special attribute giving the length of a tone. An unsigned integer
+ * duration in milliseconds, at most 10000. Defaults to 200.
+ *
+ * This attribute is handled by GSound and never passed to the sound server.
+ */
+#define GSOUND_ATTR_GSOUND_TONE_DURATION               "gsound.tone.duration"
+
+/**
+ * GSOUND_ATTR_GSOUND_TONE_ATTACK:
+ *
+ * A special attribute giving the time over which a tone fades in. An
+ * unsigned integer duration in milliseconds. Defaults to 5.
+ *
+ * This attribute is handled by GSound and never passed to the sound server.
+ */
+#define GSOUND_ATTR_GSOUND_TONE_ATTACK                 "gsound.tone.attack"
+
+/**
+ * GSOUND_ATTR_GSOUND_TONE_RELEASE:
+ *
+ * A special attribute giving the time over which a tone fades out at its
+ * end. An unsigned integer duration in milliseconds. Defaults to 50.
+ *
+ * This attribute is handled by GSound and never passed to the sound server.
+ */
+#define GSOUND_ATTR_GSOUND_TONE_RELEASE                "gsound.tone.release"
+
+/**
+ * GSoundAttrKey:
+ * @GSOUND_ATTR_KEY_NONE: Not a known attribute
+ * @GSOUND_ATTR_KEY_MEDIA_NAME: #GSOUND_ATTR_MEDIA_NAME
+ * @GSOUND_ATTR_KEY_MEDIA_TITLE: #GSOUND_ATTR_MEDIA_TITLE
+ * @GSOUND_ATTR_KEY_MEDIA_ARTIST: #GSOUND_ATTR_MEDIA_ARTIST
+ * @GSOUND_ATTR_KEY_MEDIA_LANGUAGE: #GSOUND_ATTR_MEDIA_LANGUAGE
+ * @GSOUND_ATTR_KEY_MEDIA_FILENAME: #GSOUND_ATTR_MEDIA_FILENAME
+ * @GSOUND_ATTR_KEY_MEDIA_ICON: #GSOUND_ATTR_MEDIA_ICON
+ * @GSOUND_ATTR_KEY_MEDIA_ICON_NAME: #GSOUND_ATTR_MEDIA_ICON_NAME
+ * @GSOUND_ATTR_KEY_MEDIA_ROLE: #GSOUND_ATTR_MEDIA_ROLE
+ * @GSOUND_ATTR_KEY_EVENT_ID: #GSOUND_ATTR_EVENT_ID
+ * @GSOUND_ATTR_KEY_EVENT_DESCRIPTION: #GSOUND_ATTR_EVENT_DESCRIPTION
+ * @GSOUND_ATTR_KEY_EVENT_MOUSE_X: #GSOUND_ATTR_EVENT_MOUSE_X
+ * @GSOUND_ATTR_KEY_EVENT_MOUSE_Y: #GSOUND_ATTR_EVENT_MOUSE_Y
+ * @GSOUND_ATTR_KEY_EVENT_MOUSE_HPOS: #GSOUND_ATTR_EVENT_MOUSE_HPOS
+ * @GSOUND_ATTR_KEY_EVENT_MOUSE_VPOS: #GSOUND_ATTR_EVENT_MOUSE_VPOS
+ * @GSOUND_ATTR_KEY_EVENT_MOUSE_BUTTON: #GSOUND_ATTR_EVENT_MOUSE_BUTTON
+ * @GSOUND_ATTR_KEY_WINDOW_NAME: #GSOUND_ATTR_WINDOW_NAME
+ * @GSOUND_ATTR_KEY_WINDOW_ID: #GSOUND_ATTR_WINDOW_ID
+ * @GSOUND_ATTR_KEY_WINDOW_ICON: #GSOUND_ATTR_WINDOW_ICON
+ * @GSOUND_ATTR_KEY_WINDOW_ICON_NAME: #GSOUND_ATTR_WINDOW_ICON_NAME
+ * @GSOUND_ATTR_KEY_WINDOW_X: #GSOUND_ATTR_WINDOW_X
+ * @GSOUND_ATTR_KEY_WINDOW_Y: #GSOUND_ATTR_WINDOW_Y
+ * @GSOUND_ATTR_KEY_WINDOW_WIDTH: #GSOUND_ATTR_WINDOW_WIDTH
+ * @GSOUND_ATTR_KEY_WINDOW_HEIGHT: #GSOUND_ATTR_WINDOW_HEIGHT
+ * @GSOUND_ATTR_KEY_WINDOW_HPOS: #GSOUND_ATTR_WINDOW_HPOS
+ * @GSOUND_ATTR_KEY_WINDOW_VPOS: #GSOUND_ATTR_WINDOW_VPOS
+ * @GSOUND_ATTR_KEY_WINDOW_DESKTOP: #GSOUND_ATTR_WINDOW_DESKTOP
+ * @GSOUND_ATTR_KEY_WINDOW_X11_DISPLAY: #GSOUND_ATTR_WINDOW_X11_DISPLAY
+ * @GSOUND_ATTR_KEY_WINDOW_X11_SCREEN: #GSOUND_ATTR_WINDOW_X11_SCREEN
+ * @GSOUND_ATTR_KEY_WINDOW_X11_MONITOR: #GSOUND_ATTR_WINDOW_X11_MONITOR
+ * @GSOUND_ATTR_KEY_WINDOW_X11_XID: #GSOUND_ATTR_WINDOW_X11_XID
+ * @GSOUND_ATTR_KEY_APPLICATION_NAME: #GSOUND_ATTR_APPLICATION_NAME
+ * @GSOUND_ATTR_KEY_APPLICATION_ID: #GSOUND_ATTR_APPLICATION_ID
+ * @GSOUND_ATTR_KEY_APPLICATION_VERSION: #GSOUND_ATTR_APPLICATION_VERSION
+ * @GSOUND_ATTR_KEY_APPLICATION_ICON: #GSOUND_ATTR_APPLICATION_ICON
+ * @GSOUND_ATTR_KEY_APPLICATION_ICON_NAME: #GSOUND_ATTR_APPLICATION_ICON_NAME
+ * @GSOUND_ATTR_KEY_APPLICATION_LANGUAGE: #GSOUND_ATTR_APPLICATION_LANGUAGE
+ * @GSOUND_ATTR_KEY_APPLICATION_PROCESS_ID: #GSOUND_ATTR_APPLICATION_PROCESS_ID
+ * @GSOUND_ATTR_KEY_APPLICATION_PROCESS_BINARY: #GSOUND_ATTR_APPLICATION_PROCESS_BINARY
+ * @GSOUND_ATTR_KEY_APPLICATION_PROCESS_USER: #GSOUND_ATTR_APPLICATION_PROCESS_USER
+ * @GSOUND_ATTR_KEY_APPLICATION_PROCESS_HOST: #GSOUND_ATTR_APPLICATION_PROCESS_HOST
+ * @GSOUND_ATTR_KEY_CANBERRA_CACHE_CONTROL: #GSOUND_ATTR_CANBERRA_CACHE_CONTROL
+ * @GSOUND_ATTR_KEY_CANBERRA_VOLUME: #GSOUND_ATTR_CANBERRA_VOLUME
+ * @GSOUND_ATTR_KEY_CANBERRA_XDG_THEME_NAME: #GSOUND_ATTR_CANBERRA_XDG_THEME_NAME
+ * @GSOUND_ATTR_KEY_CANBERRA_XDG_THEME_OUTPUT_PROFILE: #GSOUND_ATTR_CANBERRA_XDG_THEME_OUTPUT_PROFILE
+ * @GSOUND_ATTR_KEY_CANBERRA_ENABLE: #GSOUND_ATTR_CANBERRA_ENABLE
+ * @GSOUND_ATTR_KEY_CANBERRA_FORCE_CHANNEL: #GSOUND_ATTR_CANBERRA_FORCE_CHANNEL
+ * @GSOUND_ATTR_KEY_GSOUND_RETRIGGER: #GSOUND_ATTR_GSOUND_RETRIGGER
+ * @GSOUND_ATTR_KEY_GSOUND_GROUP: #GSOUND_ATTR_GSOUND_GROUP
+ * @GSOUND_ATTR_KEY_GSOUND_TAG: #GSOUND_ATTR_GSOUND_TAG
+ * @GSOUND_ATTR_KEY_GSOUND_TIMEOUT: #GSOUND_ATTR_GSOUND_TIMEOUT
+ * @GSOUND_ATTR_KEY_GSOUND_RENDER_OFFSET: #GSOUND_ATTR_GSOUND_RENDER_OFFSET
+ * @GSOUND_ATTR_KEY_GSOUND_RENDER_CANCEL: #GSOUND_ATTR_GSOUND_RENDER_CANCEL
+ * @GSOUND_ATTR_KEY_GSOUND_RENDER_FADE_OUT: #GSOUND_ATTR_GSOUND_RENDER_FADE_OUT
+ * @GSOUND_ATTR_KEY_GSOUND_PRIORITY: #GSOUND_ATTR_GSOUND_PRIORITY
+ * @GSOUND_ATTR_KEY_GSOUND_TONE_FREQUENCY: #GSOUND_ATTR_GSOUND_TONE_FREQUENCY
+ * @GSOUND_ATTR_KEY_GSOUND_TONE_FREQUENCY_END: #GSOUND_ATTR_GSOUND_TONE_FREQUENCY_END
+ * @GSOUND_ATTR_KEY_GSOUND_TONE_WAVEFORM: #GSOUND_ATTR_GSOUND_TONE_WAVEFORM
+ * @GSOUND_ATTR_KEY_GSOUND_TONE_DURATION: #GSOUND_ATTR_GSOUND_TONE_DURATION
+ * @GSOUND_ATTR_KEY_GSOUND_TONE_ATTACK: #GSOUND_ATTR_GSOUND_TONE_ATTACK
+ * @GSOUND_ATTR_KEY_GSOUND_TONE_RELEASE: #GSOUND_ATTR_GSOUND_TONE_RELEASE
+ *
+ * Identifies one of the attributes defined by GSound, for use with
+ * gsound_context_play_simple_keys() and gsound_context_play_full_keys().
+ * Passing key ids rather than strings saves GSound from looking the keys
+ * up on every call.
+ *
+ * Attributes not listed here can still be passed by name.
+ */
+typedef enum
+{
+  GSOUND_ATTR_KEY_NONE = 0,
+  GSOUND_ATTR_KEY_MEDIA_NAME,
+  GSOUND_ATTR_KEY_MEDIA_TITLE,
+  GSOUND_ATTR_KEY_MEDIA_ARTIST,
+  GSOUND_ATTR_KEY_MEDIA_LANGUAGE,
+  GSOUND_ATTR_KEY_MEDIA_FILENAME,
+  GSOUND_ATTR_KEY_MEDIA_ICON,
+  GSOUND_ATTR_KEY_MEDIA_ICON_NAME,
+  GSOUND_ATTR_KEY_MEDIA_ROLE,
+  GSOUND_ATTR_KEY_EVENT_ID,
+  GSOUND_ATTR_KEY_EVENT_DESCRIPTION,
+  GSOUND_ATTR_KEY_EVENT_MOUSE_X,
+  GSOUND_ATTR_KEY_EVENT_MOUSE_Y,
+  GSOUND_ATTR_KEY_EVENT_MOUSE_HPOS,
+  GSOUND_ATTR_KEY_EVENT_MOUSE_VPOS,
+  GSOUND_ATTR_KEY_EVENT_MOUSE_BUTTON,
+  GSOUND_ATTR_KEY_WINDOW_NAME,
+  GSOUND_ATTR_KEY_WINDOW_ID,
+  GSOUND_ATTR_KEY_WINDOW_ICON,
+  GSOUND_ATTR_KEY_WINDOW_ICON_NAME,
+  GSOUND_ATTR_KEY_WINDOW_X,
+  GSOUND_ATTR_KEY_WINDOW_Y,
+  GSOUND_ATTR_KEY_WINDOW_WIDTH,
+  GSOUND_ATTR_KEY_WINDOW_HEIGHT,
+  GSOUND_ATTR_KEY_WINDOW_HPOS,
+  GSOUND_ATTR_KEY_WINDOW_VPOS,
+  GSOUND_ATTR_KEY_WINDOW_DESKTOP,
+  GSOUND_ATTR_KEY_WINDOW_X11_DISPLAY,
+  GSOUND_ATTR_KEY_WINDOW_X11_SCREEN,
+  GSOUND_ATTR_KEY_WINDOW_X11_MONITOR,
+  GSOUND_ATTR_KEY_WINDOW_X11_XID,
+  GSOUND_ATTR_KEY_APPLICATION_NAME,
+  GSOUND_ATTR_KEY_APPLICATION_ID,
+  GSOUND_ATTR_KEY_APPLICATION_VERSION,
+  GSOUND_ATTR_KEY_APPLICATION_ICON,
+  GSOUND_ATTR_KEY_APPLICATION_ICON_NAME,
+  GSOUND_ATTR_KEY_APPLICATION_LANGUAGE,
+  GSOUND_ATTR_KEY_APPLICATION_PROCESS_ID,
+  GSOUND_ATTR_KEY_APPLICATION_PROCESS_BINARY,
+  GSOUND_ATTR_KEY_APPLICATION_PROCESS_USER,
+  GSOUND_ATTR_KEY_APPLICATION_PROCESS_HOST,
+  GSOUND_ATTR_KEY_CANBERRA_CACHE_CONTROL,
+  GSOUND_ATTR_KEY_CANBERRA_VOLUME,
+  GSOUND_ATTR_KEY_CANBERRA_XDG_THEME_NAME,
+  GSOUND_ATTR_KEY_CANBERRA_XDG_THEME_OUTPUT_PROFILE,
+  GSOUND_ATTR_KEY_CANBERRA_ENABLE,
+  GSOUND_ATTR_KEY_CANBERRA_FORCE_CHANNEL,
+  GSOUND_ATTR_KEY_GSOUND_RETRIGGER,
+  GSOUND_ATTR_KEY_GSOUND_GROUP,
+  GSOUND_ATTR_KEY_GSOUND_TAG,
+  GSOUND_ATTR_KEY_GSOUND_TIMEOUT,
+  GSOUND_ATTR_KEY_GSOUND_RENDER_OFFSET,
+  GSOUND_ATTR_KEY_GSOUND_RENDER_CANCEL,
+  GSOUND_ATTR_KEY_GSOUND_RENDER_FADE_OUT,
+  GSOUND_ATTR_KEY_GSOUND_PRIORITY,
+  GSOUND_ATTR_KEY_GSOUND_TONE_FREQUENCY,
+  GSOUND_ATTR_KEY_GSOUND_TONE_FREQUENCY_END,
+  GSOUND_ATTR_KEY_GSOUND_TONE_WAVEFORM,
+  GSOUND_ATTR_KEY_GSOUND_TONE_DURATION,
+  GSOUND_ATTR_KEY_GSOUND_TONE_ATTACK,
+  GSOUND_ATTR_KEY_GSOUND_TONE_RELEASE,
+
+  /*< private >*/
+  GSOUND_ATTR_N_KEYS
+} GSoundAttrKey;
+
+GSoundAttrKey gsound_attr_key_from_string (const char    *key);
+
+const char   *gsound_attr_key_to_string   (GSoundAttrKey  key);
 
 G_END_DECLS
 
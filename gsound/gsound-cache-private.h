@@ -0,0 +1,56 @@
+/* gsound-cache-private.h
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GSOUND_CACHE_PRIVATE_H
+#define GSOUND_CACHE_PRIVATE_H
+
+#include "gsound-clip-private.h"
+#include "gsound-context.h"
+#include "gsound-tone-private.h"
+
+G_BEGIN_DECLS
+
+/*
+ * GSoundCachedClip:
+ *
+ * A sound preloaded by gsound_context_preload(), kept in memory as chosen
+ * by its #GSoundCacheStorage. Cached clips are immutable and may be shared
+ * between threads.
+ */
+typedef struct _GSoundCachedClip GSoundCachedClip;
+
+GSoundCachedClip *gsound_cached_clip_load         (const char          *filename,
+                                                   const GSoundTone    *tone,
+                                                   GSoundCacheStorage   storage,
+                                                   GError             **error);
+
+GSoundCachedClip *gsound_cached_clip_ref          (GSoundCachedClip    *cached);
+
+void              gsound_cached_clip_unref        (GSoundCachedClip    *cached);
+
+gsize             gsound_cached_clip_get_size     (GSoundCachedClip    *cached);
+
+gsize             gsound_cached_clip_get_pcm_size (GSoundCachedClip    *cached);
+
+GSoundClip       *gsound_cached_clip_unpack       (GSoundCachedClip    *cached,
+                                                   guint                rate,
+                                                   GError             **error);
+
+G_END_DECLS
+
+#endif /* GSOUND_CACHE_PRIVATE_H */
@@ -0,0 +1,344 @@
+/* gsound-cache.c
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gsound-cache-private.h"
+#include "gsound-adpcm-private.h"
+
+/* Scratch buffers are kept for the next clip up to the size of the
+ * largest clip preloaded compressed, and at least this many samples */
+#define MIN_SCRATCH_SAMPLES (1 << 20)
+
+struct _GSoundCachedClip
+{
+  gint               ref_count;
+
+  GSoundCacheStorage storage;
+  guint              rate;
+  guint              channels;
+  gsize              n_frames;
+
+  /* The decoded clip, for GSOUND_CACHE_STORAGE_PCM */
+  GSoundClip        *clip;
+
+  /* The ADPCM samples, or the contents of the original file */
+  GBytes            *data;
+
+  /* For GSOUND_CACHE_STORAGE_ORIGINAL without @data, the tone to
+   * synthesize */
+  GSoundTone         tone;
+};
+
+/* A buffer which each thread decodes compressed clips into before
+ * converting them to the output rate, so that rendering does not allocate
+ * a decoded copy of every clip */
+typedef struct
+{
+  float *samples;
+  gsize  n_allocated;
+} GSoundScratch;
+
+static void
+scratch_free (gpointer data)
+{
+  GSoundScratch *scratch = data;
+
+  g_free (scratch->samples);
+  g_free (scratch);
+}
+
+static GPrivate scratch_key = G_PRIVATE_INIT (scratch_free);
+
+/* In samples, only ever growing */
+static gpointer largest_compressed_clip;
+
+static void
+note_compressed_clip (gsize n_samples)
+{
+  gpointer largest;
+
+  do
+    {
+      largest = g_atomic_pointer_get (&largest_compressed_clip);
+      if (n_samples <= GPOINTER_TO_SIZE (largest))
+        return;
+    }
+  while (!g_atomic_pointer_compare_and_exchange (&largest_compressed_clip,
+                                                 largest,
+                                                 GSIZE_TO_POINTER (n_samples)));
+}
+
+static float *
+scratch_acquire (gsize n_samples)
+{
+  GSoundScratch *scratch = g_private_get (&scratch_key);
+
+  if (!scratch)
+    {
+      scratch = g_new0 (GSoundScratch, 1);
+      g_private_set (&scratch_key, scratch);
+    }
+
+  if (scratch->n_allocated < n_samples)
+    {
+      g_free (scratch->samples);
+      scratch->samples = g_new (float, n_samples);
+      scratch->n_allocated = n_samples;
+    }
+
+  return scratch->samples;
+}
+
+static void
+scratch_release (void)
+{
+  GSoundScratch *scratch = g_private_get (&scratch_key);
+  gpointer largest;
+
+  largest = g_atomic_pointer_get (&largest_compressed_clip);
+
+  if (scratch->n_allocated > MAX (GPOINTER_TO_SIZE (largest),
+                                  MIN_SCRATCH_SAMPLES))
+    {
+      g_clear_pointer (&scratch->samples, g_free);
+      scratch->n_allocated = 0;
+    }
+}
+
+/*
+ * gsound_cached_clip_load:
+ * @filename: (nullable): path of the sound file, or %NULL for a tone
+ * @tone: the tone to synthesize if @filename is %NULL
+ * @storage: how to keep the sound
+ * @error: Return location for error
+ *
+ * Loads a sound to be kept in memory as @storage says. Sounds are decoded
+ * whatever the storage, so that errors show up at once.
+ *
+ * Returns: (transfer full): the cached clip, or %NULL on error
+ */
+GSoundCachedClip *
+gsound_cached_clip_load (const char          *filename,
+                         const GSoundTone    *tone,
+                         GSoundCacheStorage   storage,
+                         GError             **error)
+{
+  GSoundCachedClip *cached;
+  GBytes *original = NULL;
+  GSoundClip *clip;
+
+  if (!filename)
+    {
+      clip = gsound_tone_render (tone, GSOUND_TONE_RATE);
+    }
+  else if (storage == GSOUND_CACHE_STORAGE_ORIGINAL)
+    {
+      GError *inner_error = NULL;
+      char *contents;
+      gsize length;
+
+      if (!g_file_get_contents (filename, &contents, &length, &inner_error))
+        {
+          g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_NOTFOUND,
+                               inner_error->message);
+          g_error_free (inner_error);
+          return NULL;
+        }
+
+      original = g_bytes_new_take (contents, length);
+      clip = gsound_clip_decode ((const guint8 *) contents, length,
+                                 &inner_error);
+      if (!clip)
+        {
+          g_propagate_prefixed_error (error, inner_error, "“%s”: ", filename);
+          g_bytes_unref (original);
+          return NULL;
+        }
+    }
+  else
+    {
+      clip = gsound_clip_load (filename, error);
+      if (!clip)
+        return NULL;
+    }
+
+  cached = g_slice_new0 (GSoundCachedClip);
+  cached->ref_count = 1;
+  cached->storage = storage;
+  cached->rate = clip->rate;
+  cached->channels = clip->channels;
+  cached->n_frames = clip->n_frames;
+
+  switch (storage)
+    {
+    case GSOUND_CACHE_STORAGE_PCM:
+      cached->clip = gsound_clip_ref (clip);
+      break;
+
+    case GSOUND_CACHE_STORAGE_ADPCM:
+      cached->data = gsound_adpcm_encode (clip);
+      note_compressed_clip (clip->n_frames * clip->channels);
+      break;
+
+    case GSOUND_CACHE_STORAGE_ORIGINAL:
+      /* A tone's description is all there is to keep */
+      if (original)
+        {
+          cached->data = original;
+          note_compressed_clip (clip->n_frames * clip->channels);
+        }
+      else
+        cached->tone = *tone;
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+
+  gsound_clip_unref (clip);
+
+  return cached;
+}
+
+GSoundCachedClip *
+gsound_cached_clip_ref (GSoundCachedClip *cached)
+{
+  g_atomic_int_inc (&cached->ref_count);
+  return cached;
+}
+
+void
+gsound_cached_clip_unref (GSoundCachedClip *cached)
+{
+  if (!g_atomic_int_dec_and_test (&cached->ref_count))
+    return;
+
+  g_clear_pointer (&cached->clip, gsound_clip_unref);
+  g_clear_pointer (&cached->data, g_bytes_unref);
+  g_slice_free (GSoundCachedClip, cached);
+}
+
+/*
+ * gsound_cached_clip_get_size:
+ * @cached: a #GSoundCachedClip
+ *
+ * Returns: the memory in bytes taken by the samples of @cached
+ */
+gsize
+gsound_cached_clip_get_size (GSoundCachedClip *cached)
+{
+  if (cached->clip)
+    return cached->n_frames * cached->channels * sizeof (float);
+  else if (cached->data)
+    return g_bytes_get_size (cached->data);
+  else
+    return 0;
+}
+
+/*
+ * gsound_cached_clip_get_pcm_size:
+ * @cached: a #GSoundCachedClip
+ *
+ * Returns: the memory in bytes the samples of @cached take when decoded
+ */
+gsize
+gsound_cached_clip_get_pcm_size (GSoundCachedClip *cached)
+{
+  return cached->n_frames * cached->channels * sizeof (float);
+}
+
+/* Decodes the samples of @cached, which are not kept decoded, into
+ * @clip */
+static gboolean
+unpack_into (GSoundCachedClip  *cached,
+             GSoundClip        *clip,
+             GError           **error)
+{
+  if (cached->storage == GSOUND_CACHE_STORAGE_ADPCM)
+    {
+      gsound_adpcm_decode (cached->data, cached->channels,
+                           cached->n_frames, clip->samples);
+      return TRUE;
+    }
+
+  if (!gsound_clip_decode_into (g_bytes_get_data (cached->data, NULL),
+                                g_bytes_get_size (cached->data),
+                                clip, error))
+    return FALSE;
+
+  /* The file decoded to this many frames when it was loaded */
+  if (clip->n_frames != cached->n_frames)
+    {
+      g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_CORRUPT,
+                           "Cached sound decoded to a different length");
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/*
+ * gsound_cached_clip_unpack:
+ * @cached: a #GSoundCachedClip
+ * @rate: the sample rate in Hz to convert the clip to
+ * @error: Return location for error
+ *
+ * Gets the samples of @cached at @rate, decoding them if they are not kept
+ * decoded. Converting to @rate is done as by gsound_clip_resample(), from
+ * a buffer which is reused by the calling thread.
+ *
+ * Returns: (transfer full): the clip, or %NULL on error
+ */
+GSoundClip *
+gsound_cached_clip_unpack (GSoundCachedClip  *cached,
+                           guint              rate,
+                           GError           **error)
+{
+  GSoundClip *clip;
+
+  switch (cached->storage)
+    {
+    case GSOUND_CACHE_STORAGE_PCM:
+      return gsound_clip_resample (cached->clip, rate);
+
+    case GSOUND_CACHE_STORAGE_ADPCM:
+    case GSOUND_CACHE_STORAGE_ORIGINAL:
+      if (!cached->data)
+        return gsound_tone_render (&cached->tone, rate);
+      else if (cached->rate == rate || cached->n_frames == 0)
+        {
+          clip = gsound_clip_new (cached->rate, cached->channels,
+                                  cached->n_frames);
+          if (!unpack_into (cached, clip, error))
+            g_clear_pointer (&clip, gsound_clip_unref);
+        }
+      else
+        {
+          GSoundClip scratch = { 1, cached->rate, cached->channels,
+                                 cached->n_frames, NULL };
+
+          scratch.samples = scratch_acquire (cached->n_frames * cached->channels);
+          clip = unpack_into (cached, &scratch, error)
+                 ? gsound_clip_resample (&scratch, rate) : NULL;
+          scratch_release ();
+        }
+      return clip;
+
+    default:
+      g_assert_not_reached ();
+    }
+}
@@ -0,0 +1,100 @@
+/* gsound-clip-private.h
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GSOUND_CLIP_PRIVATE_H
+#define GSOUND_CLIP_PRIVATE_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * GSoundClip:
+ *
+ * A decoded sound held in memory as interleaved 32-bit float samples in
+ * the range [-1.0, 1.0]. Clips are immutable once loaded and may be shared
+ * between threads.
+ */
+typedef struct _GSoundClip GSoundClip;
+
+struct _GSoundClip
+{
+  gint   ref_count;
+
+  guint  rate;
+  guint  channels;
+  gsize  n_frames;
+  float *samples;
+};
+
+/* Fetches frame @pos of @clip resampled by @step, the ratio of the clip's
+ * rate to the output rate, with linear interpolation between neighbouring
+ * source frames */
+static inline void
+gsound_clip_read_frame (GSoundClip *clip,
+                        gsize       pos,
+                        double      step,
+                        float      *frame)
+{
+  const float *a, *b;
+  double src = pos * step;
+  gsize index = (gsize) src;
+  float frac = (float) (src - index);
+  guint c;
+
+  a = clip->samples + index * clip->channels;
+  b = index + 1 < clip->n_frames ? a + clip->channels : a;
+
+  for (c = 0; c < clip->channels; c++)
+    frame[c] = a[c] + (b[c] - a[c]) * frac;
+}
+
+GSoundClip *gsound_clip_new          (guint        rate,
+                                      guint        channels,
+                                      gsize        n_frames);
+
+GSoundClip *gsound_clip_ref          (GSoundClip  *clip);
+
+void        gsound_clip_unref        (GSoundClip  *clip);
+
+GSoundClip *gsound_clip_resample      (GSoundClip  *clip,
+                                      guint        rate);
+
+GSoundClip *gsound_clip_decode       (const guint8 *data,
+                                      gsize         length,
+                                      GError      **error);
+
+gboolean    gsound_clip_decode_into  (const guint8 *data,
+                                      gsize         length,
+                                      GSoundClip   *clip,
+                                      GError      **error);
+
+GSoundClip *gsound_clip_load         (const char  *filename,
+                                      GError     **error);
+
+GBytes     *gsound_clip_encode_wav   (guint        rate,
+                                      guint        channels,
+                                      GBytes      *pcm);
+
+char       *gsound_clip_lookup_event (const char  *event_id,
+                                      const char  *theme,
+                                      const char  *profile);
+
+G_END_DECLS
+
+#endif /* GSOUND_CLIP_PRIVATE_H */
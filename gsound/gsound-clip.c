@@ -0,0 +1,548 @@
+/* gsound-clip.c
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gsound-clip-private.h"
+#include "gsound-context.h"
+#include "gsound-decoder-private.h"
+
+#include <glib/gstdio.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+
+#define WAVE_FORMAT_PCM 0x0001
+
+#define MAX_CHANNELS 8
+
+GSoundClip *
+gsound_clip_new (guint rate,
+                 guint channels,
+                 gsize n_frames)
+{
+  GSoundClip *clip;
+
+  clip = g_slice_new0 (GSoundClip);
+  clip->ref_count = 1;
+  clip->rate = rate;
+  clip->channels = channels;
+  clip->n_frames = n_frames;
+  clip->samples = g_new0 (float, n_frames * channels);
+
+  return clip;
+}
+
+GSoundClip *
+gsound_clip_ref (GSoundClip *clip)
+{
+  g_atomic_int_inc (&clip->ref_count);
+  return clip;
+}
+
+void
+gsound_clip_unref (GSoundClip *clip)
+{
+  if (!g_atomic_int_dec_and_test (&clip->ref_count))
+    return;
+
+  g_free (clip->samples);
+  g_slice_free (GSoundClip, clip);
+}
+
+/*
+ * gsound_clip_resample:
+ * @clip: a #GSoundClip
+ * @rate: the new sample rate in Hz
+ *
+ * Converts @clip to @rate the same way as #GSoundMixer does when mixing
+ * it, so that mixing the result gives the same output.
+ *
+ * Returns: (transfer full): the resampled clip, or a new reference to
+ *   @clip if it is already at @rate
+ */
+GSoundClip *
+gsound_clip_resample (GSoundClip *clip,
+                      guint       rate)
+{
+  double step = (double) clip->rate / rate;
+  GSoundClip *resampled;
+  gsize n_frames, i;
+
+  if (clip->rate == rate || clip->n_frames == 0)
+    return gsound_clip_ref (clip);
+
+  n_frames = (gsize) ceil ((clip->n_frames - 1) / step) + 1;
+  resampled = gsound_clip_new (rate, clip->channels, n_frames);
+
+  for (i = 0; i < n_frames; i++)
+    gsound_clip_read_frame (clip, i, step,
+                            resampled->samples + i * clip->channels);
+
+  return resampled;
+}
+
+/* Frames decoded at a time when the length is not known in advance */
+#define READ_FRAMES 4096
+
+/* The length in a header is only trusted this far before the clip has to
+ * grow as the frames actually arrive */
+#define MAX_PREALLOC_FRAMES (256 * READ_FRAMES)
+
+/* Longest clip decoded, as for rendering */
+#define MAX_CLIP_SECONDS (10 * 60)
+
+/* Makes room in @clip for up to @n_frames, but no more than @max_frames,
+ * failing if it already has that many */
+static gboolean
+grow_clip (GSoundClip  *clip,
+           gsize       *n_allocated,
+           gsize        n_frames,
+           gsize        max_frames,
+           const char  *name,
+           GError     **error)
+{
+  float *samples;
+  gsize n_bytes;
+
+  n_frames = MIN (n_frames, max_frames);
+
+  if (n_frames <= *n_allocated ||
+      !g_size_checked_mul (&n_bytes, n_frames,
+                           clip->channels * sizeof (float)))
+    {
+      g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_NOTSUPPORTED,
+                   "%s stream is longer than %u seconds", name,
+                   MAX_CLIP_SECONDS);
+      return FALSE;
+    }
+
+  if (!(samples = g_try_realloc (clip->samples, n_bytes)))
+    {
+      g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_OOM,
+                   "Out of memory decoding %s stream", name);
+      return FALSE;
+    }
+
+  clip->samples = samples;
+  *n_allocated = n_frames;
+
+  return TRUE;
+}
+
+static GSoundClip *
+decode (const GSoundDecoder  *decoder,
+        const guint8         *data,
+        gsize                 length,
+        GSoundClipInfo       *info,
+        gboolean              cached,
+        GError              **error)
+{
+  GSoundClip *clip;
+  gpointer state;
+  gsize n_allocated;
+  gsize n_first;
+  gsize max_frames;
+
+  if (!(state = decoder->open (data, length, info, cached, error)))
+    return NULL;
+
+  if (info->channels == 0 || info->channels > MAX_CHANNELS || info->rate == 0)
+    {
+      g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_NOTSUPPORTED,
+                   "Unsupported %s channel layout", decoder->name);
+      decoder->close (state);
+      return NULL;
+    }
+
+  /* The length comes from the file, or from a cached probe of it, so a
+   * bad one must fail the decode rather than the allocation */
+  max_frames = (gsize) info->rate * MAX_CLIP_SECONDS;
+  if (info->n_frames > max_frames)
+    {
+      g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_CORRUPT,
+                   "%s header gives a length of %" G_GUINT64_FORMAT
+                   " frames", decoder->name, (guint64) info->n_frames);
+      decoder->close (state);
+      return NULL;
+    }
+
+  /* Read straight into the clip, growing it only if the header did not
+   * give the length, gave it wrong, or gave more than is preallocated */
+  clip = g_slice_new0 (GSoundClip);
+  clip->ref_count = 1;
+  clip->rate = info->rate;
+  clip->channels = info->channels;
+  n_allocated = 0;
+  n_first = info->n_frames ? MIN (info->n_frames, MAX_PREALLOC_FRAMES)
+                           : READ_FRAMES;
+
+  while (TRUE)
+    {
+      gssize n_read;
+
+      if (clip->n_frames == n_allocated &&
+          !grow_clip (clip, &n_allocated,
+                      n_allocated ? n_allocated * 2 : n_first,
+                      max_frames, decoder->name, error))
+        {
+          g_clear_pointer (&clip, gsound_clip_unref);
+          break;
+        }
+
+      n_read = decoder->read (state,
+                              clip->samples + clip->n_frames * info->channels,
+                              n_allocated - clip->n_frames, error);
+      if (n_read < 0)
+        {
+          g_clear_pointer (&clip, gsound_clip_unref);
+          break;
+        }
+      else if (n_read == 0)
+        break;
+
+      clip->n_frames += n_read;
+    }
+
+  decoder->close (state);
+
+  if (clip && clip->n_frames < n_allocated)
+    clip->samples = g_renew (float, clip->samples,
+                             clip->n_frames * info->channels);
+
+  return clip;
+}
+
+/*
+ * gsound_clip_decode:
+ * @data: the contents of a sound file
+ * @length: the length of @data
+ * @error: Return location for error
+ *
+ * Decodes a sound file already in memory, such as one kept by
+ * #GSOUND_CACHE_STORAGE_ORIGINAL, with the first built-in decoder which
+ * recognises it.
+ *
+ * Returns: (transfer full): the decoded clip, or %NULL on error
+ */
+GSoundClip *
+gsound_clip_decode (const guint8 *data,
+                    gsize         length,
+                    GError      **error)
+{
+  GSoundClipInfo info = { NULL };
+
+  info.decoder = gsound_decoder_probe (data, length);
+  if (!info.decoder)
+    {
+      g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_NOTSUPPORTED,
+                           "Not in a supported sound format");
+      return NULL;
+    }
+
+  return decode (info.decoder, data, length, &info, FALSE, error);
+}
+
+/*
+ * gsound_clip_decode_into:
+ * @data: the contents of a sound file
+ * @length: the length of @data
+ * @clip: a clip with the rate and channels of the file, whose samples
+ *   hold room for @clip->n_frames frames
+ * @error: Return location for error
+ *
+ * Decodes a sound file already in memory into a buffer the caller owns,
+ * for files decoded before whose format is known, such as those kept by
+ * #GSOUND_CACHE_STORAGE_ORIGINAL. At most @clip->n_frames frames are
+ * decoded, and @clip->n_frames is set to the number there were.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+gsound_clip_decode_into (const guint8  *data,
+                         gsize          length,
+                         GSoundClip    *clip,
+                         GError       **error)
+{
+  GSoundClipInfo info = { NULL };
+  gpointer state;
+  gsize n_frames = 0;
+  gssize n_read = 0;
+
+  info.decoder = gsound_decoder_probe (data, length);
+  if (!info.decoder)
+    {
+      g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_NOTSUPPORTED,
+                           "Not in a supported sound format");
+      return FALSE;
+    }
+
+  if (!(state = info.decoder->open (data, length, &info, FALSE, error)))
+    return FALSE;
+
+  if (info.rate != clip->rate || info.channels != clip->channels)
+    {
+      g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_CORRUPT,
+                   "%s stream format changed", info.decoder->name);
+      info.decoder->close (state);
+      return FALSE;
+    }
+
+  while (n_frames < clip->n_frames)
+    {
+      n_read = info.decoder->read (state,
+                                   clip->samples + n_frames * clip->channels,
+                                   clip->n_frames - n_frames, error);
+      if (n_read <= 0)
+        break;
+
+      n_frames += n_read;
+    }
+
+  info.decoder->close (state);
+
+  if (n_read < 0)
+    return FALSE;
+
+  clip->n_frames = n_frames;
+
+  return TRUE;
+}
+
+/*
+ * gsound_clip_load:
+ * @filename: path of the sound file
+ * @error: Return location for error
+ *
+ * Decodes @filename into a new #GSoundClip with the first built-in decoder
+ * which recognises it. What was learnt from the file's header is cached,
+ * so that decoding the file again skips the parsing the format allows.
+ *
+ * Returns: (transfer full): the decoded clip, or %NULL on error
+ */
+GSoundClip *
+gsound_clip_load (const char *filename,
+                  GError    **error)
+{
+  GError *inner_error = NULL;
+  GSoundClipInfo info = { NULL };
+  const guint8 *data;
+  GMappedFile *map;
+  GSoundClip *clip;
+  gboolean have_stat;
+  gboolean cached = FALSE;
+  struct stat st;
+  gsize length;
+  int fd;
+
+  fd = g_open (filename, O_RDONLY | O_CLOEXEC, 0);
+  if (fd < 0)
+    {
+      int saved_errno = errno;
+
+      g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_NOTFOUND,
+                   "Failed to open “%s”: %s", filename,
+                   g_strerror (saved_errno));
+      return NULL;
+    }
+
+  /* The cached information is keyed by the version of the file which is
+   * mapped, whatever happens to the path meanwhile */
+  have_stat = fstat (fd, &st) == 0;
+
+  map = g_mapped_file_new_from_fd (fd, FALSE, &inner_error);
+  g_close (fd, NULL);
+  if (!map)
+    {
+      g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_NOTFOUND,
+                   "“%s”: %s", filename, inner_error->message);
+      g_error_free (inner_error);
+      return NULL;
+    }
+
+  data = (const guint8 *) g_mapped_file_get_contents (map);
+  length = g_mapped_file_get_length (map);
+
+  if (have_stat)
+    cached = gsound_decoder_info_lookup (&st, &info);
+  if (!cached)
+    info.decoder = gsound_decoder_probe (data, length);
+
+  if (!info.decoder)
+    {
+      g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_NOTSUPPORTED,
+                   "“%s” is not in a supported sound format", filename);
+      g_mapped_file_unref (map);
+      return NULL;
+    }
+
+  clip = decode (info.decoder, data, length, &info, cached, &inner_error);
+  if (!clip)
+    {
+      g_propagate_prefixed_error (error, inner_error, "“%s”: ", filename);
+    }
+  else if (!cached && have_stat)
+    {
+      info.n_frames = clip->n_frames;
+      gsound_decoder_info_insert (&st, &info);
+    }
+
+  g_mapped_file_unref (map);
+
+  return clip;
+}
+
+static void
+append_le32 (GByteArray *array,
+             guint32     value)
+{
+  guint8 b[4] = { value, value >> 8, value >> 16, value >> 24 };
+
+  g_byte_array_append (array, b, 4);
+}
+
+static void
+append_le16 (GByteArray *array,
+             guint16     value)
+{
+  guint8 b[2] = { value, value >> 8 };
+
+  g_byte_array_append (array, b, 2);
+}
+
+/*
+ * gsound_clip_encode_wav:
+ * @rate: sample rate in Hz
+ * @channels: number of channels
+ * @pcm: interleaved signed 16-bit little-endian samples
+ *
+ * Returns: (transfer full): @pcm as the contents of a WAV file
+ */
+GBytes *
+gsound_clip_encode_wav (guint   rate,
+                        guint   channels,
+                        GBytes *pcm)
+{
+  GByteArray *wav;
+  gconstpointer data;
+  gsize size;
+
+  data = g_bytes_get_data (pcm, &size);
+
+  wav = g_byte_array_sized_new (44 + size);
+  g_byte_array_append (wav, (const guint8 *) "RIFF", 4);
+  append_le32 (wav, 36 + size);
+  g_byte_array_append (wav, (const guint8 *) "WAVEfmt ", 8);
+  append_le32 (wav, 16);
+  append_le16 (wav, WAVE_FORMAT_PCM);
+  append_le16 (wav, channels);
+  append_le32 (wav, rate);
+  append_le32 (wav, rate * channels * 2);
+  append_le16 (wav, channels * 2);
+  append_le16 (wav, 16);
+  g_byte_array_append (wav, (const guint8 *) "data", 4);
+  append_le32 (wav, size);
+  g_byte_array_append (wav, data, size);
+
+  return g_byte_array_free_to_bytes (wav);
+}
+
+static char *
+lookup_in_theme (const char *theme,
+                 const char *profile,
+                 const char *name)
+{
+  const char * const *system_dirs = g_get_system_data_dirs ();
+  const GSoundDecoder * const *decoders = gsound_decoder_get_all ();
+  const char *subdirs[] = { profile, "", NULL };
+  guint n_dirs = g_strv_length ((char **) system_dirs) + 1;
+  guint d, s, f, e;
+
+  for (d = 0; d < n_dirs; d++)
+    {
+      const char *dir = d == 0 ? g_get_user_data_dir () : system_dirs[d - 1];
+
+      for (s = 0; subdirs[s]; s++)
+        for (f = 0; decoders[f]; f++)
+          for (e = 0; decoders[f]->extensions[e]; e++)
+          {
+            char *basename = g_strconcat (name, decoders[f]->extensions[e], NULL);
+            char *path = g_build_filename (dir, "sounds", theme, subdirs[s],
+                                           basename, NULL);
+
+            g_free (basename);
+
+            if (g_file_test (path, G_FILE_TEST_IS_REGULAR))
+              return path;
+
+            g_free (path);
+          }
+    }
+
+  return NULL;
+}
+
+/*
+ * gsound_clip_lookup_event:
+ * @event_id: an XDG sound naming specification event id
+ * @theme: (nullable): sound theme name, or %NULL for "freedesktop"
+ * @profile: (nullable): output profile, or %NULL for "stereo"
+ *
+ * Resolves @event_id to a file following the XDG sound theme
+ * specification, falling back to less specific names ("dialog-warning"
+ * for "dialog-warning-auth") and to the "freedesktop" theme.
+ *
+ * Returns: (transfer full) (nullable): the file name, or %NULL
+ */
+char *
+gsound_clip_lookup_event (const char *event_id,
+                          const char *theme,
+                          const char *profile)
+{
+  const char *themes[] = { theme ? theme : "freedesktop", "freedesktop", NULL };
+  guint t;
+
+  if (!profile)
+    profile = "stereo";
+
+  for (t = 0; themes[t]; t++)
+    {
+      char *name;
+      char *path = NULL;
+
+      if (t > 0 && g_strcmp0 (themes[t], themes[0]) == 0)
+        break;
+
+      name = g_strdup (event_id);
+      while (!path)
+        {
+          char *dash;
+
+          path = lookup_in_theme (themes[t], profile, name);
+
+          if (!(dash = strrchr (name, '-')))
+            break;
+          *dash = '\0';
+        }
+      g_free (name);
+
+      if (path)
+        return path;
+    }
+
+  return NULL;
+}
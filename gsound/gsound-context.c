@@ -146,580 +146,4457 @@
  * 
  * See the documentation for #GSOUND_ATTR_CANBERRA_CACHE_CONTROL for more
  * details.
+ *
+ * # Offline Rendering
+ *
+ * gsound_context_render() mixes a timeline of sounds into a PCM buffer
+ * without touching the sound server, which is useful for regression tests,
+ * for exporting previews and as a deterministic benchmark. Each timeline
+ * entry is a set of attributes as would be passed to a `play()` call, placed
+ * in time with #GSOUND_ATTR_GSOUND_RENDER_OFFSET.
+ *
+ * Rendering decodes the sounds it needs in parallel, on a shared pool of
+ * threads sized to the number of processors; the `GSOUND_THREADS`
+ * environment variable overrides the size. gsound_context_preload()
+ * decodes sounds ahead of time and keeps them for later renders. On devices
+ * short of memory, gsound_context_set_cache_storage() keeps preloaded
+ * sounds compressed instead, to be decoded again each time they are
+ * rendered.
+ *
+ * # Synthesized Tones
+ *
+ * Simple beeps and chirps need not be shipped as sound files. A sound with
+ * #GSOUND_ATTR_GSOUND_TONE_FREQUENCY set is synthesized by GSound instead,
+ * shaped by the other "gsound.tone" attributes:
+ *
+ * |[<!-- language="C" -->
+ * gsound_context_play_simple (ctx, NULL, NULL,
+ *                             GSOUND_ATTR_GSOUND_TONE_FREQUENCY, "880",
+ *                             GSOUND_ATTR_GSOUND_TONE_FREQUENCY_END, "1320",
+ *                             GSOUND_ATTR_GSOUND_TONE_DURATION, "120",
+ *                             NULL);
+ * ]|
+ *
+ * As libcanberra can only play files, each tone is synthesized into an
+ * anonymous in-memory file, which later plays of the same tone reuse for as
+ * long as it is among the most recently played tones.
+ *
+ * # Multiple Outputs
+ *
+ * A context normally plays on the default output of one sound server.
+ * gsound_context_add_output() adds further outputs, such as other devices
+ * or drivers, and each sound played on the context is then sent to all of
+ * them in parallel, completing once all have finished.
+ *
+ * # Tracing
+ *
+ * If the `GSOUND_TRACE` environment variable names a file, every play is
+ * logged to it in the Chrome trace event format, from submission through
+ * queueing, acceptance by the backend and start to completion,
+ * cancellation or failure, along with its attributes. The file can be
+ * opened in Perfetto (https://ui.perfetto.dev) to inspect overlapping
+ * sounds, queueing and latency.
+ *
+ * For stress testing, `GSOUND_FAULT` makes GSound simulate a degraded
+ * sound server by delaying, failing or losing the completion of calls to
+ * libcanberra, for example
+ * `GSOUND_FAULT=latency=20,jitter=30,error=disconnected,error-rate=0.1,lost=0.01`.
+ * Combined with #GSoundContext:timeout and gsound_context_get_stats() this
+ * shows how an application copes with, and recovers from, server trouble.
  * 
  */
 
+#include "gsound-attr-private.h"
+#include "gsound-cache-private.h"
 #include "gsound-context.h"
+#include "gsound-fault-private.h"
+#include "gsound-mixer-private.h"
+#include "gsound-pool-private.h"
+#include "gsound-record-private.h"
+#include "gsound-tone-private.h"
+#include "gsound-trace-private.h"
+
+#include <canberra.h>
+
+#include <math.h>
+#include <stdarg.h>
+
+static void gsound_context_initable_init (GInitableIface *iface);
+
+/* Attributes by which in-flight plays are indexed for
+ * gsound_context_cancel_matching() */
+static const GSoundAttrKey indexed_attrs[] = {
+  GSOUND_ATTR_KEY_EVENT_ID,
+  GSOUND_ATTR_KEY_WINDOW_ID,
+  GSOUND_ATTR_KEY_WINDOW_X11_XID,
+  GSOUND_ATTR_KEY_GSOUND_GROUP,
+  GSOUND_ATTR_KEY_GSOUND_TAG,
+};
+
+#define N_INDEXED_ATTRS G_N_ELEMENTS (indexed_attrs)
+
+#define MAX_OUTPUTS 8
+
+/* Threads cancelling plays which timed out, each of which may be stuck
+ * behind a hung backend for a while */
+#define MAX_CANCEL_THREADS 4
+
+/* The values of #GSOUND_ATTR_CANBERRA_CACHE_CONTROL, the first being the
+ * default for gsound_context_preload() */
+static const char * const cache_classes[] = {
+  "permanent",
+  "volatile",
+  "never",
+};
+
+#define N_CACHE_CLASSES G_N_ELEMENTS (cache_classes)
+
+typedef struct _GSoundPlay GSoundPlay;
+typedef struct _GSoundGroup GSoundGroup;
+typedef struct _GSoundDriverRace GSoundDriverRace;
+
+struct _GSoundContext
+{
+  GObject     parent;
+
+  ca_context *ca;
+
+  /* For a child context, the context it was created from and the root
+   * context whose connection and bookkeeping it shares */
+  GSoundContext *parent_context;
+  GSoundContext *root;
+
+  /* Further backends every play is fanned out to, see
+   * gsound_context_add_output(). Outputs are only ever added, under
+   * @attributes_lock, and @n_outputs is published once the slot is set,
+   * so plays can read them without locking. */
+  ca_context *outputs[MAX_OUTPUTS];
+  gint        n_outputs;
+
+  /* Bit mask of the outputs which failed to take a change of attributes,
+   * under @attributes_lock. They are sent all of them with the next
+   * change. */
+  guint       stale_outputs;
+
+  /* The candidates of the last gsound_context_set_drivers(), some of
+   * which may still be opening */
+  GSoundDriverRace *driver_race;
+
+  guint       render_fade_out;
+  guint       timeout;
+
+  /* The context attributes as last set on @ca, which libcanberra offers
+   * no way to read back. The lock is held across updates of @ca. For a
+   * child context these are its own attributes, layered over those of its
+   * parent, and the table is replaced rather than modified. */
+  GMutex      attributes_lock;
+  GHashTable *attributes;
+
+  /* Bumped under @attributes_lock whenever @attributes of a root context
+   * change, so that a backend opened from a copy of them can catch up */
+  guint       attributes_serial;
+
+  /* Protects everything below, which may be touched from the caller's
+   * thread, from cancellation handlers and from the worker thread */
+  GMutex      lock;
+  GHashTable *events;
+  GHashTable *groups;
+  GPtrArray  *duckings;
+  GHashTable *index[N_INDEXED_ATTRS];
+  GHashTable *clips;
+  GSoundCacheStorage cache_storage[N_CACHE_CLASSES];
+  GSoundStats stats;
+
+  /* Whether @ca has been opened, or used to play or cache a sound, after
+   * which gsound_context_set_drivers() may no longer replace it, and
+   * whether it is being replaced, which those wait for on @backend_cond */
+  gboolean    backend_used;
+  gboolean    replacing_backend;
+  GCond       backend_cond;
+
+  /* Quality of service, see gsound_context_set_qos_thresholds(): the
+   * thresholds, and running averages of the start latency and of the
+   * proportion of sounds failing as of @qos_time */
+  gint64      qos_max_latency;
+  double      qos_max_error_rate;
+  double      qos_latency;
+  double      qos_error_rate;
+  gint64      qos_time;
+};
+
+struct _GSoundContextClass
+{
+  GObjectClass parent_class;
+};
+
+G_DEFINE_TYPE_WITH_CODE (GSoundContext, gsound_context, G_TYPE_OBJECT,
+                         G_IMPLEMENT_INTERFACE (G_TYPE_INITABLE,
+                                                gsound_context_initable_init))
+
+G_DEFINE_QUARK (gsound - error - quark, gsound_error);
+
+enum
+{
+  PROP_0,
+  PROP_RENDER_FADE_OUT,
+  PROP_TIMEOUT,
+  N_PROPS
+};
+
+static GParamSpec *properties[N_PROPS];
+
+enum
+{
+  STARTED,
+  N_SIGNALS
+};
+
+static guint signals[N_SIGNALS];
+
+static gboolean
+test_return (int code, GError **error)
+{
+  if (code == CA_SUCCESS)
+    return TRUE;
+
+  g_set_error_literal (error, GSOUND_ERROR, code, ca_strerror (code));
+  return FALSE;
+}
+
+typedef enum
+{
+  GSOUND_RETRIGGER_OVERLAP,
+  GSOUND_RETRIGGER_RESTART,
+  GSOUND_RETRIGGER_IGNORE,
+  GSOUND_RETRIGGER_QUEUE
+} GSoundRetrigger;
+
+typedef enum
+{
+  GSOUND_PLAY_QUEUED,
+  GSOUND_PLAY_PLAYING,
+  GSOUND_PLAY_FINISHED
+} GSoundPlayState;
+
+/* A single play request, from submission until the backend reports that
+ * it has finished. Plays with an event id are also kept in the context's
+ * event table so that retrigger policies can be enforced. */
+struct _GSoundPlay
+{
+  gint             ref_count;
+
+  GSoundContext   *context;
+  guint32          id;
+  GSoundPlayState  state;
+  int              error_code;
+  gint             completed;
+  gint             timed_out;
+
+  /* Under the context lock: whether the play has been handed to the
+   * backends, and whether it was cancelled while playing, which if it had
+   * not yet been handed over gsound_play_start() acts on once it has */
+  gboolean         submitted;
+  gboolean         cancel_requested;
+
+  /* Backends which have yet to report completion, and how the others
+   * fared, for a play fanned out to several outputs, and whether any has
+   * accepted the play yet */
+  gint             pending_outputs;
+  gint             n_succeeded;
+  gint             output_error;
+  gint             accepted;
+
+  guint            timeout;
+  GSource         *timeout_source;
+
+  /* The context the sound was played on, for a child context not
+   * @context, and where to emit GSoundContext::started if anyone was
+   * listening */
+  GSoundContext   *owner;
+  GMainContext    *main_context;
+  gint64           submit_time;
+  gint64           start_latency;
+
+  char            *event_id;
+  GSoundGroup     *group;
+  ca_proplist     *proplist;
+
+  GTask           *task;
+  GCancellable    *cancellable;
+  gulong           cancelled_id;
+
+  /* The file of a synthesized tone, which the backends read as they play */
+  GSoundToneFile  *tone_file;
+
+  /* Values of indexed_attrs, borrowed from the index keys while the play
+   * is indexed, and our links in the index buckets */
+  gboolean         indexed;
+  const char      *index_values[N_INDEXED_ATTRS];
+  GList            index_links[N_INDEXED_ATTRS];
+};
+
+/* Per event id bookkeeping: the instances currently playing, and those
+ * waiting for them to finish under the "queue" retrigger policy */
+typedef struct
+{
+  GQueue playing;
+  GQueue queued;
+} GSoundEvent;
+
+/* A named mix group. Groups are created on first use and released again
+ * once no play refers to them and they have no settings, see
+ * gsound_context_release_group(). Only plays which have been handed to the
+ * backend count as voices. */
+struct _GSoundGroup
+{
+  const char *name;
+  double      volume;
+  guint       max_voices;
+  GQueue      playing;
+
+  /* Plays referring to the group, whether queued or playing */
+  guint       n_plays;
+};
+
+typedef struct
+{
+  char   *group;
+  char   *trigger;
+  double  attenuation;
+} GSoundDucking;
+
+typedef struct
+{
+  const char *key;
+  const char *value;
+} GSoundAttr;
+
+static gboolean gsound_play_start (GSoundPlay  *play,
+                                   GError     **error);
+
+static void
+gsound_event_free (GSoundEvent *event)
+{
+  g_queue_clear (&event->playing);
+  g_queue_clear (&event->queued);
+  g_slice_free (GSoundEvent, event);
+}
+
+static void
+gsound_group_free (GSoundGroup *group)
+{
+  g_queue_clear (&group->playing);
+  g_slice_free (GSoundGroup, group);
+}
+
+static void
+gsound_ducking_free (GSoundDucking *ducking)
+{
+  g_free (ducking->group);
+  g_free (ducking->trigger);
+  g_slice_free (GSoundDucking, ducking);
+}
+
+/* Called with the lock held */
+static GSoundGroup *
+gsound_context_ensure_group (GSoundContext *self,
+                             const char    *name)
+{
+  GSoundGroup *group = g_hash_table_lookup (self->groups, name);
+
+  if (!group)
+    {
+      char *key = g_strdup (name);
+
+      group = g_slice_new0 (GSoundGroup);
+      group->name = key;
+      g_hash_table_insert (self->groups, key, group);
+    }
+
+  return group;
+}
+
+/* Called with the lock held. Groups are created on demand for every group
+ * name that is played, so drop them again once they are unused and have
+ * no settings, or a long-lived process would accumulate them forever. */
+static void
+gsound_context_release_group (GSoundContext *self,
+                              GSoundGroup   *group)
+{
+  if (group->n_plays == 0 && group->volume == 0.0 && group->max_voices == 0)
+    g_hash_table_remove (self->groups, group->name);
+}
+
+/* Called with the lock held. Returns the volume adjustment in dB for a new
+ * play in group @name, taking into account ducking by other groups which
+ * are currently playing. */
+static double
+gsound_context_get_group_volume (GSoundContext *self,
+                                 const char    *name)
+{
+  GSoundGroup *group = g_hash_table_lookup (self->groups, name);
+  double volume = group ? group->volume : 0.0;
+  guint i;
+
+  for (i = 0; i < self->duckings->len; i++)
+    {
+      GSoundDucking *ducking = g_ptr_array_index (self->duckings, i);
+      GSoundGroup *trigger;
+
+      if (strcmp (ducking->group, name) != 0)
+        continue;
+
+      trigger = g_hash_table_lookup (self->groups, ducking->trigger);
+      if (trigger && !g_queue_is_empty (&trigger->playing))
+        volume -= ducking->attenuation;
+    }
+
+  return volume;
+}
+
+static gboolean
+parse_volume (const char  *value,
+              double      *volume,
+              GError     **error)
+{
+  char *end;
+
+  *volume = 0.0;
+  if (!value)
+    return TRUE;
+
+  *volume = g_ascii_strtod (value, &end);
+  if (end == value || *end != '\0')
+    {
+      g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_INVALID,
+                   "Invalid value “%s” for attribute “%s”",
+                   value, GSOUND_ATTR_CANBERRA_VOLUME);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static GPrivate attrs_scratch = G_PRIVATE_INIT ((GDestroyNotify) g_array_unref);
+
+/* Attribute arrays only live for the duration of a call, so each thread
+ * keeps one around to save allocating it on every play. A nested call,
+ * such as one made from a callback, gets a fresh array. */
+static GArray *
+attrs_new (void)
+{
+  GArray *attrs = g_private_get (&attrs_scratch);
+
+  if (!attrs)
+    return g_array_sized_new (FALSE, FALSE, sizeof (GSoundAttr), 16);
+
+  g_private_set (&attrs_scratch, NULL);
+
+  return attrs;
+}
+
+static void
+attrs_free (GArray *attrs)
+{
+  if (g_private_get (&attrs_scratch) || attrs->len > 64)
+    {
+      g_array_unref (attrs);
+      return;
+    }
+
+  g_array_set_size (attrs, 0);
+  g_private_set (&attrs_scratch, attrs);
+}
+
+/* Known keys are replaced by the strings of the key table, so that
+ * attrs_lookup() can compare pointers. Unknown keys are used as given. */
+static inline const char *
+attr_intern (const char *key)
+{
+  GSoundAttrKey id = gsound_attr_key_from_string (key);
+
+  return id != GSOUND_ATTR_KEY_NONE ? gsound_attr_key_to_string (id) : key;
+}
+
+/* Like attr_intern(), but for keys which outlive the call */
+static const char *
+attr_intern_static (const char *key)
+{
+  GSoundAttrKey id = gsound_attr_key_from_string (key);
+
+  if (id != GSOUND_ATTR_KEY_NONE)
+    return gsound_attr_key_to_string (id);
+
+  return g_intern_string (key);
+}
+
+/* The converters below validate each attribute and intern its key on the
+ * way in, so that bad requests are rejected before any other work */
+static gboolean
+var_args_to_attrs (va_list   args,
+                   GArray   *attrs,
+                   GError  **error)
+{
+  while (TRUE)
+    {
+      GSoundAttrKey id;
+      GSoundAttr attr;
+
+      attr.key = va_arg (args, const char*);
+      if (!attr.key)
+        return TRUE;
+
+      attr.value = va_arg (args, const char*);
+
+      id = gsound_attr_key_from_string (attr.key);
+      if (!gsound_attr_validate (id, attr.key, attr.value, error))
+        return FALSE;
+
+      if (id != GSOUND_ATTR_KEY_NONE)
+        attr.key = gsound_attr_key_to_string (id);
+
+      g_array_append_val (attrs, attr);
+    }
+}
+
+static gboolean
+var_args_keys_to_attrs (va_list   args,
+                        GArray   *attrs,
+                        GError  **error)
+{
+  while (TRUE)
+    {
+      GSoundAttrKey id;
+      GSoundAttr attr;
+
+      id = va_arg (args, GSoundAttrKey);
+      if (id == GSOUND_ATTR_KEY_NONE)
+        return TRUE;
+
+      if (id >= GSOUND_ATTR_N_KEYS)
+        {
+          g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_INVALID,
+                       "Invalid attribute key %u", (guint) id);
+          return FALSE;
+        }
+
+      attr.key = gsound_attr_key_to_string (id);
+      attr.value = va_arg (args, const char*);
+
+      if (!gsound_attr_validate (id, attr.key, attr.value, error))
+        return FALSE;
+
+      g_array_append_val (attrs, attr);
+    }
+}
+
+static gboolean
+hash_table_to_attrs (GHashTable  *ht,
+                     GArray      *attrs,
+                     GError     **error)
+{
+  GSoundAttr attr;
+  GHashTableIter iter;
+
+  g_hash_table_iter_init (&iter, ht);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &attr.key,
+                                 (gpointer *) &attr.value))
+    {
+      GSoundAttrKey id = gsound_attr_key_from_string (attr.key);
+
+      if (!gsound_attr_validate (id, attr.key, attr.value, error))
+        return FALSE;
+
+      if (id != GSOUND_ATTR_KEY_NONE)
+        attr.key = gsound_attr_key_to_string (id);
+
+      g_array_append_val (attrs, attr);
+    }
+
+  return TRUE;
+}
+
+/* @attrs must hold interned keys, see attr_intern() */
+static const char *
+attrs_lookup (GArray *attrs, GSoundAttrKey key)
+{
+  const char *name = gsound_attr_key_to_string (key);
+  guint i;
+
+  /* Later values override earlier ones, as with ca_proplist_sets() */
+  for (i = attrs->len; i > 0; i--)
+    {
+      GSoundAttr *attr = &g_array_index (attrs, GSoundAttr, i - 1);
+
+      if (attr->key == name)
+        return attr->value;
+    }
+
+  return NULL;
+}
+
+/* libcanberra only plays files, so a sound described by "gsound.tone"
+ * attributes is pointed at a file holding the synthesized tone, which the
+ * play must keep in @tone_file until it has finished */
+static gboolean
+attrs_add_tone (GArray          *attrs,
+                GSoundToneFile **tone_file,
+                GError         **error)
+{
+  const char *frequency = attrs_lookup (attrs, GSOUND_ATTR_KEY_GSOUND_TONE_FREQUENCY);
+  GSoundTone tone;
+  GSoundAttr attr;
+
+  if (!frequency || attrs_lookup (attrs, GSOUND_ATTR_KEY_MEDIA_FILENAME))
+    return TRUE;
+
+  if (!gsound_tone_parse (&tone, frequency,
+                          attrs_lookup (attrs, GSOUND_ATTR_KEY_GSOUND_TONE_FREQUENCY_END),
+                          attrs_lookup (attrs, GSOUND_ATTR_KEY_GSOUND_TONE_WAVEFORM),
+                          attrs_lookup (attrs, GSOUND_ATTR_KEY_GSOUND_TONE_DURATION),
+                          attrs_lookup (attrs, GSOUND_ATTR_KEY_GSOUND_TONE_ATTACK),
+                          attrs_lookup (attrs, GSOUND_ATTR_KEY_GSOUND_TONE_RELEASE),
+                          error))
+    return FALSE;
+
+  if (!(*tone_file = gsound_tone_get_file (&tone, error)))
+    return FALSE;
+
+  attr.key = gsound_attr_key_to_string (GSOUND_ATTR_KEY_MEDIA_FILENAME);
+  attr.value = gsound_tone_file_get_path (*tone_file);
+
+  g_array_append_val (attrs, attr);
+
+  return TRUE;
+}
+
+static int
+attrs_to_prop_list (GArray *attrs, ca_proplist **pl)
+{
+  guint i;
+  int res;
+
+  if ((res = ca_proplist_create (pl)) != CA_SUCCESS)
+    return res;
+
+  for (i = 0; i < attrs->len; i++)
+    {
+      GSoundAttr *attr = &g_array_index (attrs, GSoundAttr, i);
+
+      /* GSound's own attributes are meaningless to the sound server */
+      if (g_str_has_prefix (attr->key, "gsound."))
+        continue;
+
+      if ((res = ca_proplist_sets (*pl, attr->key, attr->value)) != CA_SUCCESS)
+        {
+          g_clear_pointer (pl, ca_proplist_destroy);
+          return res;
+        }
+    }
+
+  return CA_SUCCESS;
+}
+
+static gboolean
+parse_retrigger (const char       *value,
+                 GSoundRetrigger  *retrigger,
+                 GError          **error)
+{
+  static const char * const names[] = {
+    [GSOUND_RETRIGGER_OVERLAP] = "overlap",
+    [GSOUND_RETRIGGER_RESTART] = "restart",
+    [GSOUND_RETRIGGER_IGNORE] = "ignore",
+    [GSOUND_RETRIGGER_QUEUE] = "queue",
+  };
+  guint i;
+
+  *retrigger = GSOUND_RETRIGGER_OVERLAP;
+  if (!value)
+    return TRUE;
+
+  for (i = 0; i < G_N_ELEMENTS (names); i++)
+    if (strcmp (value, names[i]) == 0)
+      {
+        *retrigger = i;
+        return TRUE;
+      }
+
+  g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_INVALID,
+               "Invalid value “%s” for attribute “%s”",
+               value, GSOUND_ATTR_GSOUND_RETRIGGER);
+  return FALSE;
+}
+
+/*
+ * All backend completions are processed on a private worker thread.
+ * libcanberra invokes its callbacks from its own threads, typically with
+ * backend locks held, where it is unsafe to disconnect cancellables or to
+ * start further plays; and we can't rely on the application running a
+ * main loop for plays made with gsound_context_play_simple().
+ */
+static gpointer
+worker_thread_func (gpointer data)
+{
+  GMainContext *main_context = data;
+
+  g_main_context_push_thread_default (main_context);
+
+  while (TRUE)
+    g_main_context_iteration (main_context, TRUE);
+
+  return NULL;
+}
+
+static GMainContext *
+get_worker_context (void)
+{
+  static GMainContext *worker_context = NULL;
+
+  if (g_once_init_enter (&worker_context))
+    {
+      GMainContext *main_context = g_main_context_new ();
+
+      g_thread_unref (g_thread_new ("gsound-worker",
+                                    worker_thread_func,
+                                    main_context));
+      g_once_init_leave (&worker_context, main_context);
+    }
+
+  return worker_context;
+}
+
+static void
+worker_invoke (GSourceFunc func, gpointer data)
+{
+  GSource *source = g_idle_source_new ();
+
+  g_source_set_priority (source, G_PRIORITY_DEFAULT);
+  g_source_set_callback (source, func, data, NULL);
+  g_source_attach (source, get_worker_context ());
+  g_source_unref (source);
+}
+
+/* Cancels play @id on every backend of @self */
+static void
+gsound_context_cancel_id (GSoundContext *self,
+                          guint32        id)
+{
+  guint n_outputs = g_atomic_int_get (&self->n_outputs);
+  guint i;
+
+  ca_context_cancel (self->ca, id);
+
+  for (i = 0; i < n_outputs; i++)
+    ca_context_cancel (self->outputs[i], id);
+}
+
+/* Cancels @play on its backends. A play which has not reached them yet,
+ * because it is still being submitted or was only just taken off the
+ * queue, is cancelled by gsound_play_start() as soon as it has. */
+static void
+gsound_play_cancel_backend (GSoundPlay *play)
+{
+  GSoundContext *self = play->context;
+  gboolean submitted;
+
+  g_mutex_lock (&self->lock);
+  play->cancel_requested = TRUE;
+  submitted = play->submitted;
+  g_mutex_unlock (&self->lock);
+
+  if (submitted)
+    gsound_context_cancel_id (self, play->id);
+}
+
+static GSoundPlay *
+gsound_play_new (GSoundContext *self,
+                 GSoundContext *owner,
+                 const char    *event_id,
+                 GCancellable  *cancellable,
+                 GTask         *task)
+{
+  static gint next_id = 0;
+  GSoundPlay *play;
+
+  play = g_slice_new0 (GSoundPlay);
+  play->ref_count = 1;
+  play->context = g_object_ref (self);
+  play->id = (guint32) g_atomic_int_add (&next_id, 1);
+  play->state = GSOUND_PLAY_PLAYING;
+  play->event_id = g_strdup (event_id);
+  play->task = task ? g_object_ref (task) : NULL;
+  play->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+  play->submit_time = g_get_monotonic_time ();
+
+  play->owner = g_object_ref (owner);
+
+  if (g_signal_has_handler_pending (owner, signals[STARTED], 0, TRUE))
+    play->main_context = g_main_context_ref_thread_default ();
+
+  return play;
+}
+
+static GSoundPlay *
+gsound_play_ref (GSoundPlay *play)
+{
+  g_atomic_int_inc (&play->ref_count);
+  return play;
+}
+
+static void
+gsound_play_unref (GSoundPlay *play)
+{
+  if (!g_atomic_int_dec_and_test (&play->ref_count))
+    return;
+
+  g_clear_pointer (&play->proplist, ca_proplist_destroy);
+  g_clear_pointer (&play->tone_file, gsound_tone_file_unref);
+  g_clear_pointer (&play->timeout_source, g_source_unref);
+  g_clear_pointer (&play->main_context, g_main_context_unref);
+  g_clear_object (&play->owner);
+  g_clear_object (&play->task);
+  g_clear_object (&play->cancellable);
+  g_free (play->event_id);
+  g_object_unref (play->context);
+  g_slice_free (GSoundPlay, play);
+}
+
+static void
+gsound_index_bucket_free (GQueue *bucket)
+{
+  /* Links are embedded in the plays */
+  g_slice_free (GQueue, bucket);
+}
+
+/* Called with the lock held */
+static void
+gsound_context_index_play (GSoundContext *self,
+                           GSoundPlay    *play,
+                           GArray        *attrs)
+{
+  guint i;
+
+  for (i = 0; i < N_INDEXED_ATTRS; i++)
+    {
+      const char *value = attrs_lookup (attrs, indexed_attrs[i]);
+      gpointer key, bucket;
+
+      if (!value)
+        continue;
+
+      if (!g_hash_table_lookup_extended (self->index[i], value, &key, &bucket))
+        {
+          key = g_strdup (value);
+          bucket = g_slice_new0 (GQueue);
+          g_hash_table_insert (self->index[i], key, bucket);
+        }
+
+      play->index_values[i] = key;
+      play->index_links[i].data = play;
+      g_queue_push_tail_link (bucket, &play->index_links[i]);
+    }
+
+  play->indexed = TRUE;
+}
+
+/* Called with the lock held */
+static void
+gsound_context_unindex_play (GSoundContext *self,
+                             GSoundPlay    *play)
+{
+  guint i;
+
+  if (!play->indexed)
+    return;
+
+  for (i = 0; i < N_INDEXED_ATTRS; i++)
+    {
+      GQueue *bucket;
+
+      if (!play->index_values[i])
+        continue;
+
+      bucket = g_hash_table_lookup (self->index[i], play->index_values[i]);
+      g_queue_unlink (bucket, &play->index_links[i]);
+      if (g_queue_is_empty (bucket))
+        g_hash_table_remove (self->index[i], play->index_values[i]);
+      play->index_values[i] = NULL;
+    }
+
+  play->indexed = FALSE;
+}
+
+/* Removes @play from the context's bookkeeping. Must not be called from a
+ * cancellation handler or a backend callback. Returns the next queued play
+ * for the same event, if it should now be started. */
+static GSoundPlay *
+gsound_play_retire (GSoundPlay *play)
+{
+  GSoundContext *self = play->context;
+  GSoundPlay *next = NULL;
+  gulong cancelled_id;
+
+  g_mutex_lock (&self->lock);
+
+  gsound_context_unindex_play (self, play);
+
+  if (play->group)
+    {
+      if (play->state == GSOUND_PLAY_PLAYING)
+        g_queue_remove (&play->group->playing, play);
+      play->group->n_plays--;
+      gsound_context_release_group (self, play->group);
+      play->group = NULL;
+    }
+
+  if (play->event_id && play->state != GSOUND_PLAY_FINISHED)
+    {
+      GSoundEvent *event = g_hash_table_lookup (self->events, play->event_id);
+
+      if (play->state == GSOUND_PLAY_QUEUED)
+        g_queue_remove (&event->queued, play);
+      else
+        g_queue_remove (&event->playing, play);
+
+      if (g_queue_is_empty (&event->playing) &&
+          (next = g_queue_pop_head (&event->queued)))
+        {
+          next->state = GSOUND_PLAY_PLAYING;
+          g_queue_push_tail (&event->playing, next);
+          if (next->group)
+            g_queue_push_tail (&next->group->playing, next);
+        }
+
+      if (g_queue_is_empty (&event->playing) &&
+          g_queue_is_empty (&event->queued))
+        g_hash_table_remove (self->events, play->event_id);
+    }
+
+  play->state = GSOUND_PLAY_FINISHED;
+  cancelled_id = play->cancelled_id;
+  play->cancelled_id = 0;
+
+  g_mutex_unlock (&self->lock);
+
+  if (cancelled_id)
+    g_cancellable_disconnect (play->cancellable, cancelled_id);
+
+  return next;
+}
+
+/* Marks the backend of the root context @self as used, once any
+ * replacement by gsound_context_set_drivers() has finished. Called with
+ * the lock held. */
+static void
+gsound_context_use_backend_locked (GSoundContext *self)
+{
+  while (self->replacing_backend)
+    g_cond_wait (&self->backend_cond, &self->lock);
+
+  self->backend_used = TRUE;
+}
+
+static void
+gsound_context_use_backend (GSoundContext *self)
+{
+  g_mutex_lock (&self->lock);
+  gsound_context_use_backend_locked (self);
+  g_mutex_unlock (&self->lock);
+}
+
+/* Called with the lock held. The QoS averages are only updated by plays
+ * reaching the backend, which stops when plays are being shed, so beyond a
+ * second without samples they are taken to halve every second. */
+static double
+gsound_context_get_qos_decay (GSoundContext *self,
+                              gint64         now)
+{
+  gint64 idle = now - self->qos_time - G_USEC_PER_SEC;
+
+  return idle > 0 ? exp2 (-idle / (double) G_USEC_PER_SEC) : 1.0;
+}
+
+/* Called with the lock held */
+static void
+gsound_context_update_qos (GSoundContext *self,
+                           gint64         now)
+{
+  GSoundQosLevel level = self->stats.qos_level;
+  double pressure = 0.0;
+
+  /* How far beyond the thresholds the backend is, 1.0 being at them */
+  if (self->qos_max_latency > 0)
+    pressure = self->qos_latency / self->qos_max_latency;
+  if (self->qos_max_error_rate > 0.0)
+    pressure = MAX (pressure, self->qos_error_rate / self->qos_max_error_rate);
+  pressure *= gsound_context_get_qos_decay (self, now);
+
+  /* Levels are left well below where they are entered, to avoid flapping */
+  if (pressure >= 2.0)
+    level = GSOUND_QOS_CRITICAL;
+  else if (pressure >= 1.5)
+    level = MAX (level, GSOUND_QOS_DEGRADED);
+  else if (pressure >= 1.0)
+    level = GSOUND_QOS_DEGRADED;
+  else if (pressure >= 0.75)
+    level = MIN (level, GSOUND_QOS_DEGRADED);
+  else
+    level = GSOUND_QOS_NORMAL;
+
+  self->stats.qos_level = level;
+}
+
+/* Called with the lock held, to fold @sample into the QoS @average */
+static void
+gsound_context_add_qos_sample (GSoundContext *self,
+                               double        *average,
+                               double         sample)
+{
+  gint64 now = g_get_monotonic_time ();
+  double decay = gsound_context_get_qos_decay (self, now);
+
+  self->qos_latency *= decay;
+  self->qos_error_rate *= decay;
+  self->qos_time = now;
+
+  *average += (sample - *average) / 8;
+
+  gsound_context_update_qos (self, now);
+}
+
+/* Updates the context's statistics once @play has completed */
+static void
+gsound_play_account (GSoundPlay *play)
+{
+  GSoundStats *stats = &play->context->stats;
+
+  GSOUND_TRACE_COMPLETE (play->id, play->submit_time,
+                         play->error_code, play->timed_out);
+
+  if (play->timed_out)
+    gsound_trace_log_end (play->id, play->event_id, "timed-out", NULL);
+  else if (play->error_code == CA_SUCCESS)
+    gsound_trace_log_end (play->id, play->event_id, "finished", NULL);
+  else if (play->error_code == CA_ERROR_CANCELED)
+    gsound_trace_log_end (play->id, play->event_id, "cancelled", NULL);
+  else
+    gsound_trace_log_end (play->id, play->event_id, "error",
+                          ca_strerror (play->error_code));
+
+  g_mutex_lock (&play->context->lock);
+
+  if (play->timed_out)
+    stats->timed_out++;
+  else if (play->error_code == CA_SUCCESS)
+    stats->completed++;
+  else if (play->error_code == CA_ERROR_CANCELED)
+    stats->cancelled++;
+  else
+    stats->failed++;
+
+  if (play->error_code != CA_ERROR_CANCELED || play->timed_out)
+    gsound_context_add_qos_sample (play->context,
+                                   &play->context->qos_error_rate,
+                                   play->error_code != CA_SUCCESS ||
+                                   play->timed_out);
+
+  g_mutex_unlock (&play->context->lock);
+}
+
+static void
+gsound_play_return (GSoundPlay *play)
+{
+  if (!play->task)
+    return;
+
+  if (play->timed_out)
+    {
+      g_task_return_new_error (play->task,
+                               G_IO_ERROR,
+                               G_IO_ERROR_TIMED_OUT,
+                               "Timed out waiting for the sound to finish");
+    }
+  else if (play->error_code != CA_SUCCESS)
+    {
+      g_task_return_new_error (play->task,
+                               GSOUND_ERROR,
+                               play->error_code,
+                               "%s",
+                               ca_strerror (play->error_code));
+    }
+  else
+    g_task_return_boolean (play->task, TRUE);
+}
+
+/* Called when gsound_play_start() fails, after which the caller reports
+ * the error. Returns the next queued play to start, as for
+ * gsound_play_retire(). */
+static GSoundPlay *
+gsound_play_abort (GSoundPlay *play)
+{
+  GSoundPlay *next = gsound_play_retire (play);
+
+  gsound_play_account (play);
+
+  return next;
+}
+
+/* Starts a play that was queued behind an earlier instance of its event,
+ * dropping the queue's reference. Errors are reported through the play's
+ * task. */
+static void
+gsound_play_start_queued (GSoundPlay *play)
+{
+  while (play)
+    {
+      GSoundPlay *next = NULL;
+      GError *error = NULL;
+
+      if (gsound_play_start (play, &error))
+        {
+          gsound_play_unref (play);
+          break;
+        }
+
+      next = gsound_play_abort (play);
+      if (play->task)
+        g_task_return_error (play->task, error);
+      else
+        g_error_free (error);
+
+      gsound_play_unref (play);
+      play = next;
+    }
+}
+
+/* Completes @play on the worker thread. The caller must have won the
+ * race to set play->completed, against the backend, the timeout and a
+ * failure to start. */
+static void
+gsound_play_finish (GSoundPlay *play)
+{
+  GSoundPlay *next;
+
+  if (play->timeout_source)
+    g_source_destroy (play->timeout_source);
+
+  next = gsound_play_retire (play);
+  gsound_play_account (play);
+  gsound_play_return (play);
+
+  gsound_play_start_queued (next);
+}
+
+static gboolean
+on_play_finished_idle (gpointer user_data)
+{
+  GSoundPlay *play = user_data;
+
+  if (g_atomic_int_compare_and_exchange (&play->completed, FALSE, TRUE))
+    gsound_play_finish (play);
+
+  gsound_play_unref (play);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+cancel_call_func (gpointer data,
+                  gpointer user_data)
+{
+  GSoundPlay *play = data;
+
+  gsound_context_cancel_id (play->context, play->id);
+  gsound_play_unref (play);
+}
+
+/* Cancelling a play which timed out is done off the worker thread, as
+ * ca_context_cancel() blocks for as long as the hung ca_context_play_full()
+ * holds the backend's lock, and the worker serves every context */
+static GThreadPool *
+get_cancel_pool (void)
+{
+  static GThreadPool *cancel_pool = NULL;
+
+  if (g_once_init_enter (&cancel_pool))
+    {
+      GThreadPool *pool = g_thread_pool_new (cancel_call_func, NULL,
+                                             MAX_CANCEL_THREADS, FALSE, NULL);
+
+      g_once_init_leave (&cancel_pool, pool);
+    }
+
+  return cancel_pool;
+}
+
+static gboolean
+on_play_timeout (gpointer user_data)
+{
+  GSoundPlay *play = user_data;
+
+  /* Any completion the backend reports later is ignored */
+  if (g_atomic_int_compare_and_exchange (&play->completed, FALSE, TRUE))
+    {
+      g_atomic_int_set (&play->timed_out, TRUE);
+      gsound_play_finish (play);
+      g_thread_pool_push (get_cancel_pool (), gsound_play_ref (play), NULL);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+on_play_lost_idle (gpointer user_data)
+{
+  gsound_play_unref (user_data);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Counts the completion of @play by one of its backends. Returns TRUE for
+ * the last one, having set the combined result: the play succeeded if any
+ * backend played it, and otherwise failed with the first error. */
+static gboolean
+gsound_play_output_done (GSoundPlay *play,
+                         int         error_code)
+{
+  if (error_code == CA_SUCCESS)
+    g_atomic_int_inc (&play->n_succeeded);
+  else
+    g_atomic_int_compare_and_exchange (&play->output_error,
+                                       CA_SUCCESS, error_code);
+
+  if (!g_atomic_int_dec_and_test (&play->pending_outputs))
+    return FALSE;
+
+  if (g_atomic_int_get (&play->n_succeeded) > 0)
+    play->error_code = CA_SUCCESS;
+  else
+    play->error_code = g_atomic_int_get (&play->output_error);
+
+  return TRUE;
+}
+
+static void
+on_ca_play_full_finished (ca_context *ca,
+                          guint32     id,
+                          int         error_code,
+                          gpointer    user_data)
+{
+  GSoundPlay *play = user_data;
+
+  /* Otherwise only the backend's reference is dropped */
+  if (gsound_fault_lose_completion () ||
+      !gsound_play_output_done (play, error_code))
+    {
+      worker_invoke (on_play_lost_idle, play);
+      return;
+    }
+
+  worker_invoke (on_play_finished_idle, play);
+}
+
+static void
+gsound_play_cancel (GSoundPlay *play)
+{
+  GSoundContext *self = play->context;
+  GSoundPlayState state;
+  gboolean submitted = FALSE;
+
+  GSOUND_TRACE_CANCEL (play->id);
+  gsound_trace_log_mark (play->id, "cancel", NULL, 0);
+
+  g_mutex_lock (&self->lock);
+
+  state = play->state;
+  if (state == GSOUND_PLAY_QUEUED)
+    {
+      GSoundEvent *event = g_hash_table_lookup (self->events, play->event_id);
+
+      g_queue_remove (&event->queued, play);
+      if (g_queue_is_empty (&event->playing) &&
+          g_queue_is_empty (&event->queued))
+        g_hash_table_remove (self->events, play->event_id);
+
+      play->state = GSOUND_PLAY_FINISHED;
+    }
+  else if (state == GSOUND_PLAY_PLAYING)
+    {
+      play->cancel_requested = TRUE;
+      submitted = play->submitted;
+    }
+
+  g_mutex_unlock (&self->lock);
+
+  if (submitted)
+    gsound_context_cancel_id (self, play->id);
+  else if (state == GSOUND_PLAY_QUEUED)
+    {
+      /* The queued play holds its own reference, which the worker drops */
+      play->error_code = CA_ERROR_CANCELED;
+      worker_invoke (on_play_finished_idle, play);
+    }
+}
+
+static void
+on_cancellable_cancelled (GCancellable *cancellable,
+                          GSoundPlay   *play)
+{
+  gsound_record_cancel (play->id);
+  gsound_play_cancel (play);
+}
+
+static gboolean
+emit_started_idle (gpointer user_data)
+{
+  GSoundPlay *play = user_data;
+
+  /* The play has already been reported as timed out */
+  if (g_atomic_int_get (&play->timed_out))
+    return G_SOURCE_REMOVE;
+
+  g_signal_emit (play->owner, signals[STARTED], 0,
+                 play->event_id, play->start_latency);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Records the latency of a play which the backend has just accepted */
+static void
+gsound_play_started (GSoundPlay *play,
+                     gint64      start_time)
+{
+  GSoundContext *self = play->context;
+  gint64 now = g_get_monotonic_time ();
+  gint64 sample = now - start_time;
+
+  play->start_latency = now - play->submit_time;
+  gsound_trace_log_mark (play->id, "started", "latency", play->start_latency);
+
+  g_mutex_lock (&self->lock);
+  if (self->stats.start_latency == 0)
+    self->stats.start_latency = sample;
+  else
+    self->stats.start_latency += (sample - self->stats.start_latency) / 8;
+  gsound_context_add_qos_sample (self, &self->qos_latency, sample);
+  g_mutex_unlock (&self->lock);
+
+  if (play->main_context && !g_atomic_int_get (&play->timed_out))
+    {
+      GSource *source = g_idle_source_new ();
+
+      g_source_set_callback (source, emit_started_idle,
+                             gsound_play_ref (play),
+                             (GDestroyNotify) gsound_play_unref);
+      g_source_attach (source, play->main_context);
+      g_source_unref (source);
+    }
+}
+
+/* Records that a backend accepted @play, which counts as the play
+ * starting the first time */
+static void
+gsound_play_accepted (GSoundPlay *play,
+                      gint64      start_time)
+{
+  if (!g_atomic_int_compare_and_exchange (&play->accepted, FALSE, TRUE))
+    return;
+
+  gsound_trace_log_mark (play->id, "backend-accepted", "duration",
+                         g_get_monotonic_time () - start_time);
+  gsound_play_started (play, start_time);
+}
+
+/* The submission of a play to one of the extra outputs, which is made on
+ * the output pool without the caller waiting for it. The output's
+ * reference to the play is passed on to its completion. */
+typedef struct
+{
+  GSoundPlay *play;
+  ca_context *ca;
+  gint64      start_time;
+} GSoundOutputCall;
+
+static void
+output_call_func (gpointer data,
+                  gpointer user_data)
+{
+  GSoundOutputCall *call = data;
+  GSoundPlay *play = call->play;
+  GSoundContext *self = play->context;
+  gboolean cancel;
+  int res;
+
+  /* The proplist is only read, under its own lock, by each backend, and
+   * kept by the play until every backend is done with it */
+  if ((res = gsound_fault_call ()) == CA_SUCCESS)
+    res = ca_context_play_full (call->ca, play->id, play->proplist,
+                                on_ca_play_full_finished, play);
+
+  if (res != CA_SUCCESS)
+    {
+      /* A refusing output reports no completion of its own */
+      if (gsound_play_output_done (play, res))
+        worker_invoke (on_play_finished_idle, play);
+      else
+        worker_invoke (on_play_lost_idle, play);
+    }
+  else
+    {
+      gsound_play_accepted (play, call->start_time);
+
+      /* A cancellation sent to the outputs before this one had the play
+       * did not reach it, and nor did that of a timeout */
+      g_mutex_lock (&self->lock);
+      cancel = play->cancel_requested;
+      g_mutex_unlock (&self->lock);
+
+      if (cancel || g_atomic_int_get (&play->timed_out) ||
+          (play->cancellable && g_cancellable_is_cancelled (play->cancellable)))
+        ca_context_cancel (call->ca, play->id);
+    }
+
+  g_slice_free (GSoundOutputCall, call);
+}
+
+static GThreadPool *
+get_output_pool (void)
+{
+  static GThreadPool *output_pool = NULL;
+
+  if (g_once_init_enter (&output_pool))
+    {
+      GThreadPool *pool = g_thread_pool_new (output_call_func, NULL,
+                                             MAX_OUTPUTS, FALSE, NULL);
+
+      g_once_init_leave (&output_pool, pool);
+    }
+
+  return output_pool;
+}
+
+static gboolean
+gsound_play_start (GSoundPlay  *play,
+                   GError     **error)
+{
+  GSoundContext *self = play->context;
+  guint n_outputs = g_atomic_int_get (&self->n_outputs);
+  gboolean cancel;
+  gint64 start_time;
+  guint i;
+  int res;
+
+  if (g_cancellable_set_error_if_cancelled (play->cancellable, error))
+    {
+      play->completed = TRUE;
+      play->error_code = CA_ERROR_CANCELED;
+      return FALSE;
+    }
+
+  /* The timeout must be running before the backend calls, which are what
+   * block if the sound server hangs */
+  if (play->timeout > 0)
+    {
+      play->timeout_source = g_timeout_source_new (play->timeout);
+      g_source_set_callback (play->timeout_source, on_play_timeout,
+                             gsound_play_ref (play),
+                             (GDestroyNotify) gsound_play_unref);
+      g_source_attach (play->timeout_source, get_worker_context ());
+    }
+
+  start_time = g_get_monotonic_time ();
+
+  /* The backends' references, each dropped by its completion */
+  play->pending_outputs = n_outputs + 1;
+  for (i = 0; i <= n_outputs; i++)
+    gsound_play_ref (play);
+
+  /* Extra outputs report back through the completion, so that one which
+   * hangs holds up neither the caller nor the other outputs */
+  for (i = 0; i < n_outputs; i++)
+    {
+      GSoundOutputCall *call = g_slice_new (GSoundOutputCall);
+
+      call->play = play;
+      call->ca = self->outputs[i];
+      call->start_time = start_time;
+      g_thread_pool_push (get_output_pool (), call, NULL);
+    }
+
+  if ((res = gsound_fault_call ()) == CA_SUCCESS)
+    res = ca_context_play_full (self->ca, play->id, play->proplist,
+                                on_ca_play_full_finished, play);
+  GSOUND_TRACE_BACKEND (play->id, start_time, res);
+
+  /* From here on cancellations go straight to the backends, and any made
+   * while the main one was being called are picked up below */
+  g_mutex_lock (&self->lock);
+  play->submitted = TRUE;
+  cancel = play->cancel_requested;
+  g_mutex_unlock (&self->lock);
+
+  if (res != CA_SUCCESS)
+    {
+      gboolean last = gsound_play_output_done (play, res);
+
+      /* The backend which refused the play will not report its
+       * completion */
+      gsound_play_unref (play);
+
+      /* With extra outputs the play goes on, and the error is reported
+       * through its completion if none of them plays it either */
+      if (n_outputs > 0)
+        {
+          if (last)
+            worker_invoke (on_play_finished_idle, gsound_play_ref (play));
+          return TRUE;
+        }
+
+      /* If the timeout has already reported the play, so be it */
+      if (!g_atomic_int_compare_and_exchange (&play->completed, FALSE, TRUE))
+        return TRUE;
+
+      if (play->timeout_source)
+        g_source_destroy (play->timeout_source);
+
+      return test_return (play->error_code, error);
+    }
+
+  gsound_play_accepted (play, start_time);
+
+  /* Catch cancellation that raced with submission */
+  if (cancel ||
+      (play->cancellable && g_cancellable_is_cancelled (play->cancellable)))
+    gsound_context_cancel_id (self, play->id);
+
+  return TRUE;
+}
+
+static gboolean
+parse_timeout (const char  *value,
+               guint       *timeout,
+               GError     **error)
+{
+  guint64 ms;
+
+  if (!value)
+    return TRUE;
+
+  if (!g_ascii_string_to_unsigned (value, 10, 0, G_MAXUINT, &ms, NULL))
+    {
+      g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_INVALID,
+                   "Invalid value “%s” for attribute “%s”",
+                   value, GSOUND_ATTR_GSOUND_TIMEOUT);
+      return FALSE;
+    }
+
+  *timeout = (guint) ms;
+  return TRUE;
+}
+
+/* The lowest #GSoundQosLevel at which sounds of priority @value are shed.
+ * The value has been validated. */
+static GSoundQosLevel
+parse_priority (const char *value)
+{
+  if (!value || strcmp (value, "normal") == 0)
+    return GSOUND_QOS_CRITICAL;
+  else if (strcmp (value, "low") == 0)
+    return GSOUND_QOS_DEGRADED;
+  else
+    return GSOUND_QOS_CRITICAL + 1;
+}
+
+/*
+ * gsound_context_submit_full:
+ * @self: A root #GSoundContext
+ * @owner: the context the sound is played on, @self or one of its children
+ * @attrs: the attributes of the play
+ * @cancellable: (allow-none): A #GCancellable
+ * @task: (allow-none): the task to complete when playback finishes
+ * @error: Return location for errors which occur before the play is
+ *   handed to the backend
+ *
+ * The common implementation of all `play()` methods. On success, @task (if
+ * any) will be completed once the backend reports the play as finished.
+ */
+static gboolean
+gsound_context_submit_full (GSoundContext  *self,
+                            GSoundContext  *owner,
+                            GArray         *attrs,
+                            GCancellable   *cancellable,
+                            GTask          *task,
+                            GError        **error)
+{
+  const char *event_id = attrs_lookup (attrs, GSOUND_ATTR_KEY_EVENT_ID);
+  const char *group = attrs_lookup (attrs, GSOUND_ATTR_KEY_GSOUND_GROUP);
+  GSoundToneFile *tone_file = NULL;
+  GSoundQosLevel shed_level;
+  GSoundRetrigger retrigger;
+  guint timeout = owner->timeout;
+  double volume;
+  GSoundEvent *event = NULL;
+  GSoundPlay *play;
+  GList *restart = NULL;
+  ca_proplist *pl;
+  gboolean queued;
+  gboolean ret;
+  int res;
+
+  if (!parse_retrigger (attrs_lookup (attrs, GSOUND_ATTR_KEY_GSOUND_RETRIGGER),
+                        &retrigger, error) ||
+      !parse_volume (attrs_lookup (attrs, GSOUND_ATTR_KEY_CANBERRA_VOLUME),
+                     &volume, error) ||
+      !parse_timeout (attrs_lookup (attrs, GSOUND_ATTR_KEY_GSOUND_TIMEOUT),
+                      &timeout, error) ||
+      !attrs_add_tone (attrs, &tone_file, error))
+    return FALSE;
+
+  shed_level = parse_priority (attrs_lookup (attrs, GSOUND_ATTR_KEY_GSOUND_PRIORITY));
+
+  play = gsound_play_new (self, owner, event_id, cancellable, task);
+  play->tone_file = tone_file;
+  GSOUND_TRACE_SUBMIT (play->id, event_id);
+  gsound_record_attrs (GSOUND_RECORD_PLAY, play->id,
+                       (const char * const *) attrs->data, attrs->len);
+
+  /* Open the play's slice before anything can end it */
+  gsound_trace_log_submit (play->id, event_id,
+                           (const char * const *) attrs->data, attrs->len);
+
+  /* Shed sounds before doing any work for them when the backend is
+   * struggling */
+  g_mutex_lock (&self->lock);
+  gsound_context_use_backend_locked (self);
+  gsound_context_update_qos (self, play->submit_time);
+  if (self->stats.qos_level >= shed_level)
+    {
+      self->stats.submitted++;
+      self->stats.cancelled++;
+      self->stats.shed++;
+      g_mutex_unlock (&self->lock);
+
+      play->state = GSOUND_PLAY_FINISHED;
+      gsound_trace_log_end (play->id, event_id, "cancelled", "shed");
+      if (task)
+        g_task_return_new_error (task, GSOUND_ERROR, GSOUND_ERROR_CANCELED,
+                                 "The sound was dropped to reduce load");
+      gsound_play_unref (play);
+      return TRUE;
+    }
+  g_mutex_unlock (&self->lock);
+
+  if ((res = attrs_to_prop_list (attrs, &pl)) != CA_SUCCESS)
+    {
+      play->state = GSOUND_PLAY_FINISHED;
+      gsound_trace_log_end (play->id, event_id, "error", ca_strerror (res));
+      gsound_play_unref (play);
+      return test_return (res, error);
+    }
+
+  GSOUND_TRACE_PROPLIST (play->id, play->submit_time);
+  play->proplist = pl;
+  play->timeout = timeout;
+
+  g_mutex_lock (&self->lock);
+
+  /* Before any bookkeeping, so that failing leaves nothing to undo */
+  if (group)
+    {
+      double adjust = gsound_context_get_group_volume (self, group);
+
+      if (adjust != 0.0)
+        {
+          char buf[G_ASCII_DTOSTR_BUF_SIZE];
+
+          g_ascii_dtostr (buf, sizeof buf, volume + adjust);
+          res = ca_proplist_sets (play->proplist, GSOUND_ATTR_CANBERRA_VOLUME, buf);
+          if (res != CA_SUCCESS)
+            {
+              g_mutex_unlock (&self->lock);
+
+              play->state = GSOUND_PLAY_FINISHED;
+              gsound_trace_log_end (play->id, event_id, "error",
+                                    ca_strerror (res));
+              gsound_play_unref (play);
+              return test_return (res, error);
+            }
+        }
+    }
+
+  self->stats.submitted++;
+
+  if (event_id)
+    {
+      event = g_hash_table_lookup (self->events, event_id);
+      if (!event)
+        {
+          event = g_slice_new0 (GSoundEvent);
+          g_hash_table_insert (self->events, g_strdup (event_id), event);
+        }
+    }
+
+  if (event && !(g_queue_is_empty (&event->playing) &&
+                 g_queue_is_empty (&event->queued)))
+    {
+      GList *l;
+
+      switch (retrigger)
+        {
+        case GSOUND_RETRIGGER_OVERLAP:
+          break;
+
+        case GSOUND_RETRIGGER_RESTART:
+          for (l = event->playing.head; l; l = l->next)
+            restart = g_list_prepend (restart, gsound_play_ref (l->data));
+          break;
+
+        case GSOUND_RETRIGGER_IGNORE:
+          self->stats.cancelled++;
+          g_mutex_unlock (&self->lock);
+
+          play->state = GSOUND_PLAY_FINISHED;
+          gsound_trace_log_end (play->id, event_id, "cancelled",
+                                "already playing");
+          if (task)
+            g_task_return_new_error (task, GSOUND_ERROR, GSOUND_ERROR_CANCELED,
+                                     "Event “%s” is already playing", event_id);
+          gsound_play_unref (play);
+          return TRUE;
+
+        case GSOUND_RETRIGGER_QUEUE:
+          play->state = GSOUND_PLAY_QUEUED;
+          gsound_trace_log_mark (play->id, "queued", NULL, 0);
+          break;
+        }
+    }
+
+  gsound_context_index_play (self, play, attrs);
+
+  /* The queue holds its own reference, as the play may be started and
+   * finished by the worker thread as soon as we drop the lock */
+  queued = play->state == GSOUND_PLAY_QUEUED;
+  if (queued)
+    g_queue_push_tail (&event->queued, gsound_play_ref (play));
+  else if (event)
+    g_queue_push_tail (&event->playing, play);
+
+  if (group)
+    {
+      play->group = gsound_context_ensure_group (self, group);
+      play->group->n_plays++;
+
+      /* Steal the oldest voices to make room */
+      if (!queued && play->group->max_voices > 0)
+        {
+          while (g_queue_get_length (&play->group->playing) >= play->group->max_voices)
+            {
+              GSoundPlay *old = g_queue_pop_head (&play->group->playing);
+
+              old->group = NULL;
+              play->group->n_plays--;
+              restart = g_list_prepend (restart, gsound_play_ref (old));
+            }
+        }
+
+      if (!queued)
+        g_queue_push_tail (&play->group->playing, play);
+    }
+
+  g_mutex_unlock (&self->lock);
+
+  while (restart)
+    {
+      GSoundPlay *old = restart->data;
+
+      GSOUND_TRACE_CANCEL (old->id);
+      gsound_play_cancel_backend (old);
+      gsound_play_unref (old);
+      restart = g_list_delete_link (restart, restart);
+    }
+
+  /* Connecting runs the handler at once if @cancellable is already
+   * cancelled, which the check below picks up */
+  if (cancellable)
+    {
+      gulong cancelled_id;
+      gboolean finished;
+
+      cancelled_id = g_cancellable_connect (cancellable,
+                                            G_CALLBACK (on_cancellable_cancelled),
+                                            gsound_play_ref (play),
+                                            (GDestroyNotify) gsound_play_unref);
+
+      g_mutex_lock (&self->lock);
+      finished = play->state == GSOUND_PLAY_FINISHED;
+      if (!finished)
+        play->cancelled_id = cancelled_id;
+      g_mutex_unlock (&self->lock);
+
+      /* A queued play may already have been retired by the worker */
+      if (finished && cancelled_id)
+        g_cancellable_disconnect (cancellable, cancelled_id);
+    }
+
+  if (queued)
+    {
+      gsound_play_unref (play);
+      return TRUE;
+    }
+
+  ret = gsound_play_start (play, error);
+  if (!ret)
+    gsound_play_start_queued (gsound_play_abort (play));
+
+  gsound_play_unref (play);
+
+  return ret;
+}
+
+static inline GSoundContext *
+gsound_context_get_root (GSoundContext *self)
+{
+  return self->root ? self->root : self;
+}
+
+/* Appends the attributes of @self and its ancestors below the root to
+ * @layered, outermost first, so that later ones take precedence. The
+ * strings remain valid as long as the tables added to @layers. */
+static void
+gsound_context_layer_attrs (GSoundContext *self,
+                            GArray        *layered,
+                            GPtrArray     *layers)
+{
+  GHashTable *attributes;
+  GHashTableIter iter;
+  GSoundAttr attr;
+
+  if (!self->parent_context)
+    return;
+
+  gsound_context_layer_attrs (self->parent_context, layered, layers);
+
+  g_mutex_lock (&self->attributes_lock);
+  attributes = g_hash_table_ref (self->attributes);
+  g_mutex_unlock (&self->attributes_lock);
+
+  g_ptr_array_add (layers, attributes);
+
+  g_hash_table_iter_init (&iter, attributes);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &attr.key,
+                                 (gpointer *) &attr.value))
+    g_array_append_val (layered, attr);
+}
+
+/*
+ * gsound_context_submit:
+ * @self: A #GSoundContext
+ * @attrs: the attributes of the play
+ * @cancellable: (allow-none): A #GCancellable
+ * @task: (allow-none): the task to complete when playback finishes
+ * @error: Return location for errors
+ *
+ * Plays a sound on @self, which for a child context means playing it on
+ * the root context with the child's attributes layered underneath @attrs.
+ */
+static gboolean
+gsound_context_submit (GSoundContext  *self,
+                       GArray         *attrs,
+                       GCancellable   *cancellable,
+                       GTask          *task,
+                       GError        **error)
+{
+  GPtrArray *layers;
+  GArray *layered;
+  gboolean ret;
+
+  if (!self->parent_context)
+    return gsound_context_submit_full (self, self, attrs, cancellable,
+                                       task, error);
+
+  layers = g_ptr_array_new_with_free_func ((GDestroyNotify) g_hash_table_unref);
+  layered = attrs_new ();
+
+  gsound_context_layer_attrs (self, layered, layers);
+  g_array_append_vals (layered, attrs->data, attrs->len);
+
+  ret = gsound_context_submit_full (self->root, self, layered, cancellable,
+                                    task, error);
+
+  attrs_free (layered);
+  g_ptr_array_unref (layers);
+
+  return ret;
+}
+
+/* Called with the attributes lock held */
+static int
+gsound_context_attributes_to_proplist (GSoundContext  *self,
+                                       ca_proplist   **pl)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+  int res;
+
+  if ((res = ca_proplist_create (pl)) != CA_SUCCESS)
+    return res;
+
+  g_hash_table_iter_init (&iter, self->attributes);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    if ((res = ca_proplist_sets (*pl, key, value)) != CA_SUCCESS)
+      {
+        g_clear_pointer (pl, ca_proplist_destroy);
+        return res;
+      }
+
+  return CA_SUCCESS;
+}
+
+/*
+ * gsound_context_change_attrs:
+ * @self: A #GSoundContext
+ * @attrs: the attributes to set
+ * @error: Return location for error
+ *
+ * Sets @attrs on the context, sending only those which differ from the
+ * current values to the backend, and nothing at all if none do. Windowing
+ * attributes in particular tend to be set again on every change even when
+ * most of them are the same.
+ *
+ * The attributes are recorded once the main backend has taken them. An
+ * extra output which fails to is marked stale and sent all the attributes
+ * with the next change, and the failure is reported.
+ */
+static gboolean
+gsound_context_change_attrs (GSoundContext  *self,
+                             GArray         *attrs,
+                             GError        **error)
+{
+  ca_proplist *pl;
+  ca_proplist *all = NULL;
+  guint n_changed = 0;
+  guint i;
+  int res;
+
+  g_mutex_lock (&self->attributes_lock);
+
+  if ((res = ca_proplist_create (&pl)) != CA_SUCCESS)
+    goto out;
+
+  for (i = 0; i < attrs->len; i++)
+    {
+      GSoundAttr *attr = &g_array_index (attrs, GSoundAttr, i);
+      gboolean own = g_str_has_prefix (attr->key, "gsound.");
+
+      /* Only child contexts can hold GSound's own attributes, as they are
+       * passed with each sound rather than to the backend */
+      if ((own && !self->parent_context) ||
+          g_strcmp0 (g_hash_table_lookup (self->attributes, attr->key),
+                     attr->value) == 0)
+        continue;
+
+      if (!own &&
+          (res = ca_proplist_sets (pl, attr->key, attr->value)) != CA_SUCCESS)
+        goto out;
+
+      n_changed++;
+    }
+
+  if (n_changed == 0 && self->stale_outputs == 0)
+    goto out;
+
+  if (n_changed > 0 && !self->parent_context &&
+      (res = gsound_fault_call ()) == CA_SUCCESS)
+    res = ca_context_change_props_full (self->ca, pl);
+
+  if (res != CA_SUCCESS)
+    goto out;
+
+  if (n_changed > 0)
+    {
+      GHashTable *attributes = self->attributes;
+
+      /* Plays may be using the strings of a child's attributes */
+      if (self->parent_context)
+        {
+          GHashTableIter iter;
+          gpointer key, value;
+
+          attributes = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                              NULL, g_free);
+          g_hash_table_iter_init (&iter, self->attributes);
+          while (g_hash_table_iter_next (&iter, &key, &value))
+            g_hash_table_insert (attributes, key, g_strdup (value));
+
+          g_hash_table_unref (self->attributes);
+          self->attributes = attributes;
+        }
+
+      for (i = 0; i < attrs->len; i++)
+        {
+          GSoundAttr *attr = &g_array_index (attrs, GSoundAttr, i);
+
+          if (self->parent_context || !g_str_has_prefix (attr->key, "gsound."))
+            g_hash_table_insert (attributes,
+                                 (gpointer) attr_intern_static (attr->key),
+                                 g_strdup (attr->value));
+        }
+
+      self->attributes_serial++;
+    }
+
+  /* Every output is tried, so that one failing does not leave the others
+   * behind too */
+  for (i = 0; i < (guint) self->n_outputs; i++)
+    {
+      guint bit = 1u << i;
+      int output_res;
+
+      if (self->stale_outputs & bit)
+        {
+          output_res = CA_SUCCESS;
+          if (!all)
+            output_res = gsound_context_attributes_to_proplist (self, &all);
+          if (output_res == CA_SUCCESS)
+            output_res = ca_context_change_props_full (self->outputs[i], all);
+        }
+      else if (n_changed > 0)
+        output_res = ca_context_change_props_full (self->outputs[i], pl);
+      else
+        continue;
+
+      if (output_res == CA_SUCCESS)
+        self->stale_outputs &= ~bit;
+      else
+        {
+          self->stale_outputs |= bit;
+          if (res == CA_SUCCESS)
+            res = output_res;
+        }
+    }
+
+out:
+  g_clear_pointer (&pl, ca_proplist_destroy);
+  g_clear_pointer (&all, ca_proplist_destroy);
+  g_mutex_unlock (&self->attributes_lock);
+
+  return test_return (res, error);
+}
+
+/**
+ * gsound_context_new:
+ * @cancellable: (allow-none): A #GCancellable, or %NULL
+ * @error: Return location for error
+ *
+ * Creates and initializes a new #GSoundContext. If the an error occured
+ * during initialization, #NULL is returned and @error will be set
+ * appropriately.
+ *
+ * Returns: (transfer full): A new #GSoundContext
+ */
+GSoundContext *
+gsound_context_new (GCancellable *cancellable, GError **error)
+{
+  return GSOUND_CONTEXT (g_initable_new (GSOUND_TYPE_CONTEXT,
+                                         cancellable,
+                                         error,
+                                         NULL));
+}
+
+/**
+ * gsound_context_new_child:
+ * @parent: A #GSoundContext
+ *
+ * Creates a lightweight context which shares the connection to the sound
+ * server, the sample cache, mix groups and statistics of @parent, but has
+ * attributes of its own. These are layered over those of @parent and
+ * passed along with every sound played on the child, so a child per
+ * window can carry the window's attributes at the cost of a small
+ * allocation rather than a server connection.
+ *
+ * Attributes in the "gsound." namespace, such as #GSOUND_ATTR_GSOUND_GROUP,
+ * may also be set on a child context, as defaults for its sounds.
+ *
+ * gsound_context_cancel_matching() on a child only affects sounds whose
+ * indexed attributes, such as #GSOUND_ATTR_WINDOW_ID, match those of the
+ * child. #GSoundContext::started is emitted on the context the sound was
+ * played on.
+ *
+ * Returns: (transfer full): A new #GSoundContext
+ */
+GSoundContext *
+gsound_context_new_child (GSoundContext *parent)
+{
+  GSoundContext *self;
+
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (parent), NULL);
+  g_return_val_if_fail (gsound_context_get_root (parent)->ca != NULL, NULL);
+
+  self = g_object_new (GSOUND_TYPE_CONTEXT, NULL);
+  self->parent_context = g_object_ref (parent);
+  self->root = g_object_ref (gsound_context_get_root (parent));
+  self->render_fade_out = parent->render_fade_out;
+  self->timeout = parent->timeout;
+
+  return self;
+}
+
+/**
+ * gsound_context_open:
+ * @context: A #GSoundContext
+ * @error: Return location for error
+ *
+ * Attempts to open a connection to the backend sound driver. It is recommended
+ * that you set context attributes with gsound_context_set_attributes() before
+ * calling this function.
+ *
+ * > A connection is automatically opened before playing or caching sounds,
+ * > so you rarely need to call this yourself.
+ *
+ * Returns: %TRUE if the output device was opened successfully, or %FALSE
+ *          (populating @error)
+ */
+gboolean
+gsound_context_open (GSoundContext *self, GError **error)
+{
+  int res;
+
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), FALSE);
+
+  self = gsound_context_get_root (self);
+
+  gsound_context_use_backend (self);
+
+  if ((res = gsound_fault_call ()) == CA_SUCCESS)
+    res = ca_context_open (self->ca);
+
+  return test_return (res, error);
+}
+
+/**
+ * gsound_context_set_driver:
+ * @context: A #GSoundContext
+ * @driver: libcanberra driver to use
+ * @error: Return location for error, or %NULL
+ *
+ * Sets the libcanberra driver to @driver, for example "pulse", "alsa" or "null".
+ * You normally do not need to set this yourself.
+ *
+ * Note that this function may return %TRUE even if the specified driver is
+ * not available: see the libcanberra documentation for details.
+ *
+ * Returns: %TRUE if the libcanberra driver was set successfully
+ */
+gboolean
+gsound_context_set_driver (GSoundContext *self,
+                           const char    *driver,
+                           GError       **error)
+{
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), FALSE);
+
+  if (self->parent_context)
+    {
+      g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_STATE,
+                           "The driver of a child context cannot be changed");
+      return FALSE;
+    }
+
+  return test_return (ca_context_set_driver (self->ca, driver), error);
+}
+
+/* One candidate of gsound_context_set_drivers() */
+typedef struct
+{
+  GSoundDriverRace *race;
+  char             *driver;
+  int               result;
+  gint64            open_latency;
+
+  /* The thread opening the candidate when racing, joined before the
+   * next race and when the context is finalized */
+  GThread          *thread;
+} GSoundDriverOpen;
+
+/* The candidates of one gsound_context_set_drivers() call. It is shared
+ * with the threads opening them, which may outlive the call when racing. */
+struct _GSoundDriverRace
+{
+  gint              ref_count;
+  GMutex            lock;
+  GCond             cond;
+  guint             pending;
+  ca_proplist      *proplist;
+  GSoundDriverOpen *candidates;
+  guint             n_candidates;
+  GSoundDriverOpen *winner;
+  ca_context       *ca;
+};
+
+static GSoundDriverRace *
+gsound_driver_race_ref (GSoundDriverRace *race)
+{
+  g_atomic_int_inc (&race->ref_count);
+  return race;
+}
+
+static void
+gsound_driver_race_unref (GSoundDriverRace *race)
+{
+  guint i;
+
+  if (!g_atomic_int_dec_and_test (&race->ref_count))
+    return;
+
+  for (i = 0; i < race->n_candidates; i++)
+    g_free (race->candidates[i].driver);
+  g_free (race->candidates);
+  g_clear_pointer (&race->proplist, ca_proplist_destroy);
+  g_clear_pointer (&race->ca, ca_context_destroy);
+  g_cond_clear (&race->cond);
+  g_mutex_clear (&race->lock);
+  g_slice_free (GSoundDriverRace, race);
+}
+
+/* Waits for the threads of @race, if any, which by then have closed the
+ * drivers that lost */
+static void
+gsound_driver_race_join (GSoundDriverRace *race)
+{
+  guint i;
+
+  for (i = 0; i < race->n_candidates; i++)
+    if (race->candidates[i].thread)
+      g_thread_join (g_steal_pointer (&race->candidates[i].thread));
+}
+
+/* Opens a candidate, keeping it if it is the first to succeed. Drops a
+ * reference to the race. */
+static gpointer
+gsound_driver_open (gpointer data)
+{
+  GSoundDriverOpen *candidate = data;
+  GSoundDriverRace *race = candidate->race;
+  gint64 start_time = g_get_monotonic_time ();
+  ca_context *ca = NULL;
+  int res;
+
+  /* The proplist is only read, under its own lock */
+  if ((res = ca_context_create (&ca)) == CA_SUCCESS &&
+      (res = ca_context_set_driver (ca, candidate->driver)) == CA_SUCCESS &&
+      (res = ca_context_change_props_full (ca, race->proplist)) == CA_SUCCESS &&
+      (res = gsound_fault_call ()) == CA_SUCCESS)
+    res = ca_context_open (ca);
+
+  g_mutex_lock (&race->lock);
+
+  candidate->result = res;
+  candidate->open_latency = g_get_monotonic_time () - start_time;
+
+  if (res == CA_SUCCESS && !race->winner)
+    {
+      race->winner = candidate;
+      race->ca = g_steal_pointer (&ca);
+    }
+
+  race->pending--;
+  g_cond_signal (&race->cond);
+
+  g_mutex_unlock (&race->lock);
+
+  g_clear_pointer (&ca, ca_context_destroy);
+  gsound_driver_race_unref (race);
+
+  return NULL;
+}
+
+/**
+ * gsound_context_set_drivers:
+ * @context: A #GSoundContext
+ * @drivers: (array zero-terminated=1): %NULL-terminated list of
+ *   libcanberra drivers, in order of preference
+ * @race: whether to open all drivers at once and keep the first to succeed,
+ *   rather than trying them in turn
+ * @error: Return location for error, or %NULL
+ *
+ * Opens a connection to the first of @drivers which works, falling back to
+ * the next one when a driver is unavailable. Unlike
+ * gsound_context_set_driver(), which leaves opening the driver until a
+ * sound is played, the connection is opened at once so that failures are
+ * found.
+ *
+ * Opening a driver can take a long time, in particular when the sound
+ * server is not responding. If @race is %TRUE all drivers are opened in
+ * parallel and the first to open is used, without waiting for the others,
+ * so that a dead backend never holds up startup. The others are closed as
+ * they finish opening, and are waited for by the next call and when
+ * @context is finalized.
+ *
+ * The time taken to open each driver can be read afterwards with
+ * gsound_context_get_open_latency().
+ *
+ * This must be called before @context is opened or used to play or cache
+ * sounds. Calls made to do so while the drivers are being opened wait for
+ * them.
+ *
+ * Returns: %TRUE if one of @drivers was opened, or %FALSE (populating
+ *   @error with the error of the last driver tried)
+ */
+gboolean
+gsound_context_set_drivers (GSoundContext      *self,
+                            const char * const *drivers,
+                            gboolean            race,
+                            GError            **error)
+{
+  GSoundDriverRace *driver_race, *last_race;
+  ca_context *ca = NULL;
+  guint serial;
+  guint i;
+  int res;
+
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), FALSE);
+  g_return_val_if_fail (drivers != NULL && drivers[0] != NULL, FALSE);
+
+  if (self->parent_context)
+    {
+      g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_STATE,
+                           "The driver of a child context cannot be changed");
+      return FALSE;
+    }
+
+  /* Checked and claimed at once, so that nothing starts using the old
+   * backend until the new one is in place */
+  g_mutex_lock (&self->lock);
+  if (self->backend_used || self->replacing_backend)
+    {
+      g_mutex_unlock (&self->lock);
+      g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_STATE,
+                           "The driver cannot be changed once the context "
+                           "has been opened or used");
+      return FALSE;
+    }
+  self->replacing_backend = TRUE;
+  last_race = g_steal_pointer (&self->driver_race);
+  g_mutex_unlock (&self->lock);
+
+  /* Only the threads of one race are ever left running */
+  if (last_race)
+    {
+      gsound_driver_race_join (last_race);
+      gsound_driver_race_unref (last_race);
+    }
+
+  driver_race = g_slice_new0 (GSoundDriverRace);
+  driver_race->ref_count = 1;
+  g_mutex_init (&driver_race->lock);
+  g_cond_init (&driver_race->cond);
+  driver_race->n_candidates = g_strv_length ((char **) drivers);
+  driver_race->candidates = g_new0 (GSoundDriverOpen, driver_race->n_candidates);
+
+  for (i = 0; i < driver_race->n_candidates; i++)
+    {
+      driver_race->candidates[i].race = driver_race;
+      driver_race->candidates[i].driver = g_strdup (drivers[i]);
+      driver_race->candidates[i].open_latency = -1;
+    }
+
+  /* The drivers are opened with a copy of the attributes, so that setting
+   * them does not wait for the opening */
+  g_mutex_lock (&self->attributes_lock);
+  res = gsound_context_attributes_to_proplist (self, &driver_race->proplist);
+  serial = self->attributes_serial;
+  g_mutex_unlock (&self->attributes_lock);
+
+  if (res != CA_SUCCESS)
+    goto out;
+
+  if (race)
+    {
+      driver_race->pending = driver_race->n_candidates;
+
+      for (i = 0; i < driver_race->n_candidates; i++)
+        {
+          gsound_driver_race_ref (driver_race);
+          driver_race->candidates[i].thread =
+            g_thread_new ("gsound-open", gsound_driver_open,
+                          &driver_race->candidates[i]);
+        }
+
+      g_mutex_lock (&driver_race->lock);
+      while (!driver_race->winner && driver_race->pending > 0)
+        g_cond_wait (&driver_race->cond, &driver_race->lock);
+      g_mutex_unlock (&driver_race->lock);
+    }
+  else
+    {
+      for (i = 0; i < driver_race->n_candidates && !driver_race->winner; i++)
+        {
+          driver_race->pending = 1;
+          gsound_driver_race_ref (driver_race);
+          gsound_driver_open (&driver_race->candidates[i]);
+        }
+    }
+
+  g_mutex_lock (&driver_race->lock);
+  if (driver_race->winner)
+    ca = g_steal_pointer (&driver_race->ca);
+  else
+    res = driver_race->candidates[driver_race->n_candidates - 1].result;
+  g_mutex_unlock (&driver_race->lock);
+
+  if (!ca)
+    goto out;
+
+  /* Swapped in with any attributes set in the meantime */
+  g_mutex_lock (&self->attributes_lock);
+
+  if (self->attributes_serial != serial)
+    {
+      ca_proplist *pl = NULL;
+
+      res = gsound_context_attributes_to_proplist (self, &pl);
+      if (res == CA_SUCCESS)
+        res = ca_context_change_props_full (ca, pl);
+      g_clear_pointer (&pl, ca_proplist_destroy);
+    }
+
+  if (res == CA_SUCCESS)
+    {
+      ca_context_destroy (self->ca);
+      self->ca = g_steal_pointer (&ca);
+    }
+
+  g_mutex_unlock (&self->attributes_lock);
+
+  g_clear_pointer (&ca, ca_context_destroy);
+
+out:
+  g_mutex_lock (&self->lock);
+  self->driver_race = driver_race;
+  self->replacing_backend = FALSE;
+  g_cond_broadcast (&self->backend_cond);
+  g_mutex_unlock (&self->lock);
+
+  return test_return (res, error);
+}
+
+/**
+ * gsound_context_get_open_latency:
+ * @context: A #GSoundContext
+ * @driver: one of the drivers passed to gsound_context_set_drivers()
+ *
+ * Gets the time it took to open, or fail to open, @driver in the last call
+ * to gsound_context_set_drivers(). When racing, drivers which lost may
+ * still be opening after that call has returned.
+ *
+ * Returns: the time in microseconds, or -1 if @driver was not tried or has
+ *   not finished opening
+ */
+gint64
+gsound_context_get_open_latency (GSoundContext *self,
+                                 const char    *driver)
+{
+  GSoundDriverRace *driver_race;
+  gint64 latency = -1;
+  guint i;
+
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), -1);
+  g_return_val_if_fail (driver != NULL, -1);
+
+  self = gsound_context_get_root (self);
+
+  g_mutex_lock (&self->lock);
+  driver_race = self->driver_race ? gsound_driver_race_ref (self->driver_race) : NULL;
+  g_mutex_unlock (&self->lock);
+
+  if (!driver_race)
+    return -1;
+
+  g_mutex_lock (&driver_race->lock);
+  for (i = 0; i < driver_race->n_candidates; i++)
+    if (strcmp (driver_race->candidates[i].driver, driver) == 0)
+      {
+        latency = driver_race->candidates[i].open_latency;
+        break;
+      }
+  g_mutex_unlock (&driver_race->lock);
+
+  gsound_driver_race_unref (driver_race);
+
+  return latency;
+}
+
+/**
+ * gsound_context_add_output:
+ * @context: A #GSoundContext
+ * @driver: (allow-none): libcanberra driver to use for the output, or %NULL
+ *   for the default
+ * @device: (allow-none): device to play on, in the driver's syntax, or %NULL
+ *   for the default
+ * @error: Return location for error, or %NULL
+ *
+ * Opens a further connection to a sound server, using @driver and @device,
+ * to which every sound played on @context is also sent. This plays each
+ * sound on several outputs at once, for example on the speakers of
+ * several rooms, with a single call.
+ *
+ * Sounds are handed to the further outputs in the background, so playing
+ * a sound only waits for the context's own connection, and a sound
+ * finishes once every output has finished it. It is reported as
+ * successful if any output played it, and otherwise fails with the first
+ * error, which with further outputs is reported when the sound finishes
+ * rather than by the call to play it. #GSoundContext:timeout also covers
+ * outputs which never take the sound. Context attributes, caching and
+ * cancellation apply to all outputs.
+ *
+ * Up to eight outputs can be added to a context, and none to a child
+ * context.
+ *
+ * Returns: %TRUE if the output was opened successfully, or %FALSE
+ *          (populating @error)
+ */
+gboolean
+gsound_context_add_output (GSoundContext *self,
+                           const char    *driver,
+                           const char    *device,
+                           GError       **error)
+{
+  ca_context *ca = NULL;
+  ca_proplist *pl = NULL;
+  int res;
+
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), FALSE);
+  g_return_val_if_fail (self->ca != NULL, FALSE);
+
+  if (self->parent_context)
+    {
+      g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_STATE,
+                           "Outputs cannot be added to a child context");
+      return FALSE;
+    }
+
+  /* Held so that the output starts with the current attributes */
+  g_mutex_lock (&self->attributes_lock);
+
+  if (self->n_outputs == MAX_OUTPUTS)
+    {
+      g_mutex_unlock (&self->attributes_lock);
+      g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_TOOBIG,
+                   "A context cannot have more than %d outputs", MAX_OUTPUTS);
+      return FALSE;
+    }
+
+  if ((res = ca_context_create (&ca)) != CA_SUCCESS ||
+      (driver && (res = ca_context_set_driver (ca, driver)) != CA_SUCCESS) ||
+      (device && (res = ca_context_change_device (ca, device)) != CA_SUCCESS) ||
+      (res = gsound_context_attributes_to_proplist (self, &pl)) != CA_SUCCESS)
+    goto out;
+
+  if ((res = ca_context_change_props_full (ca, pl)) == CA_SUCCESS &&
+      (res = gsound_fault_call ()) == CA_SUCCESS)
+    res = ca_context_open (ca);
+
+  if (res == CA_SUCCESS)
+    {
+      self->outputs[self->n_outputs] = g_steal_pointer (&ca);
+      g_atomic_int_inc (&self->n_outputs);
+    }
+
+out:
+  g_clear_pointer (&pl, ca_proplist_destroy);
+  g_clear_pointer (&ca, ca_context_destroy);
+  g_mutex_unlock (&self->attributes_lock);
+
+  return test_return (res, error);
+}
+
+/**
+ * gsound_context_set_attributes: (skip)
+ * @context: A #GSoundContext
+ * @error: Return location for error
+ * @...: %NULL terminated list of attribute name-value pairs
+ *
+ * Set attributes or change attributes on @context. Subsequent calls to this
+ * function calling the same attributes will override the earlier values.
+ * Only attributes whose values differ from those already set are sent to
+ * the sound server. See gsound_context_get_attributes().
+ *
+ * Note that GSound will set the #GSOUND_ATTR_APPLICATION_NAME and
+ * #GSOUND_ATTR_APPLICATION_ID for you if using #GApplication, so you do
+ * not normally need to set these yourself.
+ *
+ * Returns: %TRUE if attributes were updated successfully
+ */
+gboolean
+gsound_context_set_attributes (GSoundContext *self,
+                               GError       **error,
+                               ...)
+{
+  GArray *attrs;
+  va_list args;
+  gboolean ret;
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), FALSE);
+
+  attrs = attrs_new ();
+
+  va_start (args, error);
+  ret = var_args_to_attrs (args, attrs, error);
+  va_end (args);
+
+  ret = ret &&
+        gsound_context_change_attrs (self, attrs, error);
+
+  attrs_free (attrs);
+
+  return ret;
+}
+
+/**
+ * gsound_context_set_attributesv: (rename-to gsound_context_set_attributes)
+ * @context: A #GSoundContext
+ * @attrs: (element-type utf8 utf8): Hash table of attributes to set
+ * @error: Return location for error, or %NULL
+ *
+ * Set attributes or change attributes on @context. Subsequent calls to this
+ * function calling the same attributes will override the earlier values.
+ * Only attributes whose values differ from those already set are sent to
+ * the sound server. See gsound_context_get_attributes().
+ *
+ * Note that GSound will set the #GSOUND_ATTR_APPLICATION_NAME and
+ * #GSOUND_ATTR_APPLICATION_ID for you if using #GApplication, so you do
+ * not normally need to set these yourself.
+ * 
+ * This function is intented to be used by language bindings.
+ *
+ * Returns: %TRUE if attributes were updated successfully
+ */
+gboolean
+gsound_context_set_attributesv (GSoundContext *self,
+                                GHashTable    *attrs,
+                                GError       **error)
+{
+  GArray *array;
+  gboolean ret;
+
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), FALSE);
+
+  array = attrs_new ();
+  ret = hash_table_to_attrs (attrs, array, error) &&
+        gsound_context_change_attrs (self, array, error);
+
+  attrs_free (array);
+
+  return ret;
+}
+
+/**
+ * gsound_context_get_attributes:
+ * @context: A #GSoundContext
+ *
+ * Gets the attributes currently set on @context, including those GSound
+ * sets itself such as #GSOUND_ATTR_APPLICATION_NAME. For a child context
+ * these are its own attributes layered over those of its parent.
+ *
+ * Returns: (transfer full) (element-type utf8 utf8): a new hash table of
+ *   the attributes
+ */
+GHashTable *
+gsound_context_get_attributes (GSoundContext *self)
+{
+  GHashTable *attrs;
+  GHashTableIter iter;
+  gpointer key, value;
+
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), NULL);
+
+  if (self->parent_context)
+    attrs = gsound_context_get_attributes (self->parent_context);
+  else
+    attrs = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
+
+  g_mutex_lock (&self->attributes_lock);
+  g_hash_table_iter_init (&iter, self->attributes);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    g_hash_table_insert (attrs, g_strdup (key), g_strdup (value));
+  g_mutex_unlock (&self->attributes_lock);
+
+  return attrs;
+}
+
+/**
+ * gsound_context_play_simple: (skip)
+ * @context: A #GSoundContext
+ * @cancellable: (allow-none): A #GCancellable, or %NULL
+ * @error: Return location for error, or %NULL
+ * @...: A %NULL-terminated list of attribute-value pairs
+ *
+ * The basic "fire-and-forget" play command. This function will not block, and
+ * just sends a request to the sound server before immediately returning.
+ *
+ * If you need to know when a sound finishes playing then you should call
+ * gsound_context_play_full() instead.
+ *
+ * You can cancel playback at any time by calling g_cancellable_cancel() on
+ * @cancellable, if supplied. 
+ *
+ * Returns: %TRUE on success, or %FALSE, populating @error
+ */
+gboolean
+gsound_context_play_simple (GSoundContext *self,
+                            GCancellable  *cancellable,
+                            GError       **error,
+                            ...)
+{
+  GArray *attrs;
+  va_list args;
+  gboolean ret;
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), FALSE);
+
+  attrs = attrs_new ();
+
+  va_start (args, error);
+  ret = var_args_to_attrs (args, attrs, error);
+  va_end (args);
+
+  ret = ret &&
+        gsound_context_submit (self, attrs, cancellable, NULL, error);
+
+  attrs_free (attrs);
+
+  return ret;
+}
+
+/**
+ * gsound_context_play_simplev: (rename-to gsound_context_play_simple)
+ * @context: A #GSoundContext
+ * @attrs: (element-type utf8 utf8): Attributes
+ * @cancellable: (allow-none): A #GCancellable
+ * @error: Return location for error
+ *
+ * The basic "fire-and-forget" play command. This function will not block, and
+ * just sends a request to the sound server before immediately returning.
+ *
+ * If you need to know when a sound finishes playing then you should call
+ * gsound_context_play_full() instead.
+ *
+ * You can cancel playback at any time by calling g_cancellable_cancel() on
+ * @cancellable, if supplied.
+ * 
+ * This function is intented to be used by language bindings.
+ *
+ * Returns: %TRUE on success, %FALSE on error
+ *
+ */
+gboolean
+gsound_context_play_simplev (GSoundContext *self,
+                             GHashTable    *attrs,
+                             GCancellable  *cancellable,
+                             GError       **error)
+{
+  GArray *array;
+  gboolean ret;
+
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), FALSE);
+
+  array = attrs_new ();
+  ret = hash_table_to_attrs (attrs, array, error) &&
+        gsound_context_submit (self, array, cancellable, NULL, error);
+
+  attrs_free (array);
+
+  return ret;
+}
+
+/**
+ * gsound_context_play_simple_keys: (skip)
+ * @context: A #GSoundContext
+ * @cancellable: (allow-none): A #GCancellable, or %NULL
+ * @error: Return location for error, or %NULL
+ * @...: A list of #GSoundAttrKey-value pairs, terminated by
+ *   %GSOUND_ATTR_KEY_NONE
+ *
+ * Like gsound_context_play_simple(), but with attributes identified by
+ * #GSoundAttrKey rather than by name, which saves looking them up.
+ *
+ * |[<!-- language="C" -->
+ * gsound_context_play_simple_keys (ctx, NULL, NULL,
+ *                                  GSOUND_ATTR_KEY_EVENT_ID, "bell",
+ *                                  GSOUND_ATTR_KEY_NONE);
+ * ]|
+ *
+ * Returns: %TRUE on success, or %FALSE, populating @error
+ */
+gboolean
+gsound_context_play_simple_keys (GSoundContext *self,
+                                 GCancellable  *cancellable,
+                                 GError       **error,
+                                 ...)
+{
+  GArray *attrs;
+  va_list args;
+  gboolean ret;
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), FALSE);
+
+  attrs = attrs_new ();
+
+  va_start (args, error);
+  ret = var_args_keys_to_attrs (args, attrs, error);
+  va_end (args);
+
+  ret = ret &&
+        gsound_context_submit (self, attrs, cancellable, NULL, error);
+
+  attrs_free (attrs);
+
+  return ret;
+}
+
+/**
+ * gsound_context_play_full: (skip)
+ * @context: A #GSoundContext
+ * @cancellable: (allow-none): A #GCancellable, or %NULL
+ * @callback: (scope async): callback
+ * @user_data: User data passed to @callback
+ * @...: A %NULL-terminated list of attribute-value pairs
+ *
+ * Asynchronously request a sound to be played. When playback is finished
+ * (or if an error occurs) then @callback will be called, following the
+ * normal GIO async pattern.
+ *
+ * If playback is cancelled via @cancellable, then @callback will be called
+ * with #G_IO_ERROR_CANCELLED.
+ *
+ * If you do not need notification of when playback is complete, you should
+ * use gsound_context_play_simple().
+ */
+void
+gsound_context_play_full (GSoundContext      *self,
+                          GCancellable       *cancellable,
+                          GAsyncReadyCallback callback,
+                          gpointer            user_data,
+                          ...)
+{
+  GError *inner_error = NULL;
+  GArray *attrs;
+  va_list args;
+  GTask *task;
+  gboolean ok;
+
+  task = g_task_new (self, cancellable, callback, user_data);
+
+  attrs = attrs_new ();
+
+  va_start (args, user_data);
+  ok = var_args_to_attrs (args, attrs, &inner_error);
+  va_end (args);
+
+  if (!ok ||
+      !gsound_context_submit (self, attrs, cancellable, task, &inner_error))
+    g_task_return_error (task, inner_error);
+
+  attrs_free (attrs);
+  g_object_unref (task);
+}
+
+/**
+ * gsound_context_play_fullv: (rename-to gsound_context_play_full)
+ * @context: A #GSoundContext
+ * @attrs: (element-type utf8 utf8): Attributes
+ * @cancellable: (allow-none): A #GCancellable, or %NULL
+ * @callback: (scope async): callback
+ * @user_data: user_data
+ *
+ * Asynchronously request a sound to be played. When playback is finished
+ * (or if an error occurs) then @callback will be called, following the
+ * normal GIO async pattern.
+ *
+ * If playback is cancelled via @cancellable, then @callback will be called
+ * with #G_IO_ERROR_CANCELLED.
+ *
+ * If you do not need notification of when playback is complete, you should
+ * use gsound_context_play_simple().
+ * 
+ * This function is intented to be used by language bindings.
+ */
+void
+gsound_context_play_fullv (GSoundContext      *self,
+                           GHashTable         *attrs,
+                           GCancellable       *cancellable,
+                           GAsyncReadyCallback callback,
+                           gpointer            user_data)
+{
+  GError *inner_error = NULL;
+  GArray *array;
+  GTask *task;
+
+  task = g_task_new (self, cancellable, callback, user_data);
+
+  array = attrs_new ();
+  if (!hash_table_to_attrs (attrs, array, &inner_error) ||
+      !gsound_context_submit (self, array, cancellable, task, &inner_error))
+    g_task_return_error (task, inner_error);
+
+  attrs_free (array);
+  g_object_unref (task);
+}
+
+/**
+ * gsound_context_play_full_keys: (skip)
+ * @context: A #GSoundContext
+ * @cancellable: (allow-none): A #GCancellable, or %NULL
+ * @callback: (scope async): callback
+ * @user_data: User data passed to @callback
+ * @...: A list of #GSoundAttrKey-value pairs, terminated by
+ *   %GSOUND_ATTR_KEY_NONE
+ *
+ * Like gsound_context_play_full(), but with attributes identified by
+ * #GSoundAttrKey rather than by name, which saves looking them up.
+ */
+void
+gsound_context_play_full_keys (GSoundContext      *self,
+                               GCancellable       *cancellable,
+                               GAsyncReadyCallback callback,
+                               gpointer            user_data,
+                               ...)
+{
+  GError *inner_error = NULL;
+  GArray *attrs;
+  va_list args;
+  GTask *task;
+  gboolean ok;
+
+  task = g_task_new (self, cancellable, callback, user_data);
+
+  attrs = attrs_new ();
+
+  va_start (args, user_data);
+  ok = var_args_keys_to_attrs (args, attrs, &inner_error);
+  va_end (args);
+
+  if (!ok ||
+      !gsound_context_submit (self, attrs, cancellable, task, &inner_error))
+    g_task_return_error (task, inner_error);
+
+  attrs_free (attrs);
+  g_object_unref (task);
+}
+
+/* Whether @play was played on @context or one of its descendants */
+static gboolean
+gsound_play_is_owned_by (GSoundPlay    *play,
+                         GSoundContext *context)
+{
+  GSoundContext *owner;
+
+  for (owner = play->owner; owner; owner = owner->parent_context)
+    if (owner == context)
+      return TRUE;
+
+  return FALSE;
+}
+
+/* The index lives on the root, so a child context scans it like the root
+ * does and then skips the sounds played on other branches */
+static gboolean
+gsound_context_cancel_matching_attrs (GSoundContext  *self,
+                                      GArray         *filter,
+                                      GError        **error)
+{
+  GSoundContext *root = gsound_context_get_root (self);
+  guint filter_index[N_INDEXED_ATTRS];
+  GQueue *smallest = NULL;
+  GList *matches = NULL;
+  GList *l;
+  guint i, k;
+
+  if (filter->len == 0)
+    {
+      g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_INVALID,
+                           "No attributes to match");
+      return FALSE;
+    }
+
+  if (filter->len > N_INDEXED_ATTRS)
+    {
+      g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_INVALID,
+                           "Too many attributes to match");
+      return FALSE;
+    }
+
+  for (i = 0; i < filter->len; i++)
+    {
+      GSoundAttr *attr = &g_array_index (filter, GSoundAttr, i);
+
+      for (k = 0; k < N_INDEXED_ATTRS; k++)
+        if (attr->key == gsound_attr_key_to_string (indexed_attrs[k]))
+          break;
+
+      if (k == N_INDEXED_ATTRS)
+        {
+          g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_NOTSUPPORTED,
+                       "Sounds cannot be matched by attribute “%s”",
+                       attr->key);
+          return FALSE;
+        }
+
+      filter_index[i] = k;
+    }
+
+  gsound_record_attrs (GSOUND_RECORD_CANCEL_MATCHING, 0,
+                       (const char * const *) filter->data, filter->len);
+
+  g_mutex_lock (&root->lock);
+
+  /* Scan the smallest bucket, checking the remaining attributes of each
+   * candidate, so that the cost depends on the number of matches */
+  for (i = 0; i < filter->len; i++)
+    {
+      GSoundAttr *attr = &g_array_index (filter, GSoundAttr, i);
+      GQueue *bucket = g_hash_table_lookup (root->index[filter_index[i]],
+                                            attr->value);
+
+      if (!bucket)
+        {
+          smallest = NULL;
+          break;
+        }
+
+      if (!smallest || bucket->length < smallest->length)
+        smallest = bucket;
+    }
+
+  for (l = smallest ? smallest->head : NULL; l; l = l->next)
+    {
+      GSoundPlay *play = l->data;
+
+      if (self != root && !gsound_play_is_owned_by (play, self))
+        continue;
+
+      for (i = 0; i < filter->len; i++)
+        {
+          GSoundAttr *attr = &g_array_index (filter, GSoundAttr, i);
+
+          if (g_strcmp0 (play->index_values[filter_index[i]], attr->value) != 0)
+            break;
+        }
+
+      if (i == filter->len)
+        matches = g_list_prepend (matches, gsound_play_ref (play));
+    }
+
+  g_mutex_unlock (&root->lock);
+
+  while (matches)
+    {
+      gsound_play_cancel (matches->data);
+      gsound_play_unref (matches->data);
+      matches = g_list_delete_link (matches, matches);
+    }
+
+  return TRUE;
+}
+
+/**
+ * gsound_context_cancel_matching: (skip)
+ * @context: A #GSoundContext
+ * @error: Return location for error, or %NULL
+ * @...: A %NULL-terminated list of attribute-value pairs
+ *
+ * Cancels every sound started on @context which is still playing or queued
+ * and which was played with all of the given attribute values. This makes
+ * it easy, for example, to cancel all sounds belonging to a window which is
+ * closing without keeping a #GCancellable for it.
+ *
+ * On a context made with gsound_context_new_child(), only the sounds played
+ * on that context or on its own children are considered, so the sounds of
+ * its parent and siblings are left alone even if their attributes match.
+ *
+ * Sounds may be matched on #GSOUND_ATTR_EVENT_ID, #GSOUND_ATTR_WINDOW_ID,
+ * #GSOUND_ATTR_WINDOW_X11_XID, #GSOUND_ATTR_GSOUND_GROUP and
+ * #GSOUND_ATTR_GSOUND_TAG. These are indexed, so the cost of this function
+ * depends on the number of matching sounds rather than on the number of
+ * sounds playing.
+ *
+ * Returns: %TRUE on success, or %FALSE if the filter was invalid
+ */
+gboolean
+gsound_context_cancel_matching (GSoundContext *self,
+                                GError       **error,
+                                ...)
+{
+  GArray *filter;
+  va_list args;
+  gboolean ret;
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), FALSE);
+
+  filter = attrs_new ();
+
+  va_start (args, error);
+  ret = var_args_to_attrs (args, filter, error);
+  va_end (args);
+
+  ret = ret &&
+        gsound_context_cancel_matching_attrs (self, filter, error);
+
+  attrs_free (filter);
+
+  return ret;
+}
+
+/**
+ * gsound_context_cancel_matchingv: (rename-to gsound_context_cancel_matching)
+ * @context: A #GSoundContext
+ * @filter: (element-type utf8 utf8): Attribute values to match
+ * @error: Return location for error, or %NULL
+ *
+ * Cancels every sound which was played with all of the attribute values in
+ * @filter. See gsound_context_cancel_matching().
+ *
+ * This function is intented to be used by language bindings.
+ *
+ * Returns: %TRUE on success, or %FALSE if the filter was invalid
+ */
+gboolean
+gsound_context_cancel_matchingv (GSoundContext *self,
+                                 GHashTable    *filter,
+                                 GError       **error)
+{
+  GArray *array;
+  gboolean ret;
+
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), FALSE);
+
+  array = attrs_new ();
+  ret = hash_table_to_attrs (filter, array, error) &&
+        gsound_context_cancel_matching_attrs (self, array, error);
+
+  attrs_free (array);
+
+  return ret;
+}
+
+/**
+ * gsound_context_play_full_finish:
+ * @context: A #GSoundContext
+ * @result: Result object passed to the callback of
+ *   gsound_context_play_full()
+ * @error: Return location for error
+ *
+ * Finish an async operation started by gsound_context_play_full(). You
+ * must call this function in the callback to free memory and receive any
+ * errors which occurred.
+ *
+ * Returns: %TRUE if playing finished successfully
+ */
+gboolean
+gsound_context_play_full_finish (GSoundContext *self,
+                                 GAsyncResult  *result,
+                                 GError       **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, self), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+static gboolean
+gsound_context_cache_attrs (GSoundContext  *self,
+                            GArray         *attrs,
+                            GError        **error)
+{
+  GSoundContext *root = gsound_context_get_root (self);
+  guint n_outputs = g_atomic_int_get (&root->n_outputs);
+  GSoundToneFile *tone_file = NULL;
+  GPtrArray *layers = NULL;
+  GArray *layered = NULL;
+  ca_proplist *pl = NULL;
+  gboolean ret;
+  guint i;
+  int res;
+
+  if (self->parent_context)
+    {
+      layers = g_ptr_array_new_with_free_func ((GDestroyNotify) g_hash_table_unref);
+      layered = attrs_new ();
+
+      gsound_context_layer_attrs (self, layered, layers);
+      g_array_append_vals (layered, attrs->data, attrs->len);
+      attrs = layered;
+    }
+
+  gsound_record_attrs (GSOUND_RECORD_CACHE, 0,
+                       (const char * const *) attrs->data, attrs->len);
+
+  /* The sound is uploaded by the time the backends return */
+  if (!attrs_add_tone (attrs, &tone_file, error))
+    {
+      ret = FALSE;
+      goto out;
+    }
+
+  gsound_context_use_backend (root);
+
+  if ((res = attrs_to_prop_list (attrs, &pl)) == CA_SUCCESS &&
+      (res = gsound_fault_call ()) == CA_SUCCESS)
+    res = ca_context_cache_full (root->ca, pl);
+
+  for (i = 0; res == CA_SUCCESS && i < n_outputs; i++)
+    res = ca_context_cache_full (root->outputs[i], pl);
+
+  ret = test_return (res, error);
+
+out:
+  g_clear_pointer (&pl, ca_proplist_destroy);
+  g_clear_pointer (&tone_file, gsound_tone_file_unref);
+  g_clear_pointer (&layered, attrs_free);
+  g_clear_pointer (&layers, g_ptr_array_unref);
+
+  return ret;
+}
+
+/**
+ * gsound_context_cache: (skip)
+ * @context: A #GSoundContext
+ * @error: Return location for error
+ * @...: A %NULL-terminated list of attribute-value pairs
+ *
+ * Requests that a sound be cached on the server. See [#caching][gsound-GSound-Context#caching].
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+gsound_context_cache (GSoundContext *self,
+                      GError       **error,
+                      ...)
+{
+  GArray *attrs;
+  va_list args;
+  gboolean ret;
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), FALSE);
+
+  attrs = attrs_new ();
+
+  va_start (args, error);
+  ret = var_args_to_attrs (args, attrs, error);
+  va_end (args);
+
+  ret = ret &&
+        gsound_context_cache_attrs (self, attrs, error);
+
+  attrs_free (attrs);
+
+  return ret;
+}
+
+/**
+ * gsound_context_cachev: (rename-to gsound_context_cache)
+ * @context: A #GSoundContext
+ * @attrs: (element-type utf8 utf8): Hash table of attrerties
+ * @error: Return location for error, or %NULL
+ * 
+ * Requests that a sound be cached on the server. See [#caching][gsound-GSound-Context#caching].
+ *
+ * This function is intented to be used by language bindings.
+ */
+gboolean
+gsound_context_cachev (GSoundContext *self,
+                       GHashTable    *attrs,
+                       GError       **error)
+{
+  GArray *array;
+  gboolean ret;
+
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), FALSE);
+
+  array = attrs_new ();
+  ret = hash_table_to_attrs (attrs, array, error) &&
+        gsound_context_cache_attrs (self, array, error);
+
+  attrs_free (array);
+
+  return ret;
+}
+
+/* Render times are capped so that a stray value fails cleanly rather
+ * than making the mixer try to allocate hours of output */
+#define MAX_RENDER_MS (10 * 60 * 1000)
+#define MAX_RENDER_RATE 384000
+
+static gboolean
+parse_render_ms (GHashTable *attrs,
+                 const char *key,
+                 guint       rate,
+                 gsize      *frames,
+                 GError    **error)
+{
+  const char *value = g_hash_table_lookup (attrs, key);
+  guint64 ms;
+
+  if (!value)
+    return TRUE;
+
+  if (!g_ascii_string_to_unsigned (value, 10, 0, MAX_RENDER_MS, &ms, NULL))
+    {
+      g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_INVALID,
+                   "Invalid value “%s” for attribute “%s”, expected a "
+                   "time of at most %d ms", value, key, MAX_RENDER_MS);
+      return FALSE;
+    }
+
+  *frames = (gsize) (ms * rate / 1000);
+  return TRUE;
+}
+
+/* The position of the event itself is more precise than that of its
+ * window, so takes precedence */
+static gboolean
+parse_render_pan (GHashTable *attrs,
+                  float      *pan,
+                  GError    **error)
+{
+  static const char * const keys[] = {
+    GSOUND_ATTR_EVENT_MOUSE_HPOS,
+    GSOUND_ATTR_WINDOW_HPOS,
+  };
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (keys); i++)
+    {
+      const char *value = g_hash_table_lookup (attrs, keys[i]);
+      double hpos;
+      char *end;
+
+      if (!value)
+        continue;
+
+      hpos = g_ascii_strtod (value, &end);
+      if (end == value || *end != '\0' || !(hpos >= 0.0 && hpos <= 1.0))
+        {
+          g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_INVALID,
+                       "Invalid value “%s” for attribute “%s”", value, keys[i]);
+          return FALSE;
+        }
+
+      *pan = (float) (2.0 * hpos - 1.0);
+      return TRUE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+parse_render_entry (GSoundContext *self,
+                    GHashTable    *attrs,
+                    guint          rate,
+                    GSoundVoice   *voice,
+                    GError       **error)
+{
+  gsize cancel = G_MAXSIZE;
+  guint64 fade_out_ms;
+  double db;
 
-#include <canberra.h>
+  fade_out_ms = MIN (self->render_fade_out, MAX_RENDER_MS);
+  voice->fade_out = (gsize) (fade_out_ms * rate / 1000);
 
-#include <stdarg.h>
+  if (!parse_render_ms (attrs, GSOUND_ATTR_GSOUND_RENDER_OFFSET, rate,
+                        &voice->offset, error) ||
+      !parse_render_ms (attrs, GSOUND_ATTR_GSOUND_RENDER_CANCEL, rate,
+                        &cancel, error) ||
+      !parse_render_ms (attrs, GSOUND_ATTR_GSOUND_RENDER_FADE_OUT, rate,
+                        &voice->fade_out, error) ||
+      !parse_render_pan (attrs, &voice->pan, error) ||
+      !parse_volume (g_hash_table_lookup (attrs, GSOUND_ATTR_CANBERRA_VOLUME),
+                     &db, error))
+    return FALSE;
 
-static void gsound_context_initable_init (GInitableIface *iface);
+  if (cancel != G_MAXSIZE)
+    voice->stop = cancel > voice->offset ? cancel - voice->offset : 0;
 
-struct _GSoundContext
-{
-  GObject     parent;
+  voice->gain = powf (10.0f, (float) db / 20.0f);
 
-  ca_context *ca;
-};
+  return TRUE;
+}
 
-struct _GSoundContextClass
+/* A distinct sound needed by gsound_context_render() or
+ * gsound_context_preload(), identified by @key: its file name, or for a
+ * tone its description prefixed with "tone:" */
+typedef struct
 {
-  GObjectClass parent_class;
-};
+  char       *key;
+  char       *filename;
+  GSoundTone  tone;
 
-G_DEFINE_TYPE_WITH_CODE (GSoundContext, gsound_context, G_TYPE_OBJECT,
-                         G_IMPLEMENT_INTERFACE (G_TYPE_INITABLE,
-                                                gsound_context_initable_init))
+  /* Rate to convert the clip to, or 0 when preloading */
+  guint       rate;
 
-G_DEFINE_QUARK (gsound - error - quark, gsound_error);
+  /* How to keep the sound when preloading */
+  GSoundCacheStorage storage;
 
-static gboolean
-test_return (int code, GError **error)
-{
-  if (code == CA_SUCCESS)
-    return TRUE;
+  /* The sound as preloaded, and the time taken to unpack it */
+  GSoundCachedClip *cached;
+  gint64      unpack_time;
 
-  g_set_error_literal (error, GSOUND_ERROR, code, ca_strerror (code));
-  return FALSE;
-}
+  GSoundClip *clip;
+  GError     *error;
+} GSoundClipLoad;
 
 static void
-hash_table_to_prop_list (GHashTable *ht, ca_proplist *pl)
+gsound_clip_load_free (GSoundClipLoad *load)
 {
-  gpointer key, value;
-  GHashTableIter iter;
+  g_free (load->key);
+  g_free (load->filename);
+  g_clear_pointer (&load->cached, gsound_cached_clip_unref);
+  g_clear_pointer (&load->clip, gsound_clip_unref);
+  g_clear_error (&load->error);
+  g_slice_free (GSoundClipLoad, load);
+}
 
-  g_hash_table_ref (ht);
+/* Finds the load of the sound described by @attrs in @loads, adding it if
+ * this is the first time the sound is seen */
+static GSoundClipLoad *
+gsound_clip_load_resolve (GHashTable  *attrs,
+                          GHashTable  *loads,
+                          guint        rate,
+                          GError     **error)
+{
+  GSoundTone tone = { 0 };
+  GSoundClipLoad *load;
+  const char *filename;
+  char *path = NULL;
+  char *key;
 
-  g_hash_table_iter_init (&iter, ht);
-  while (g_hash_table_iter_next (&iter, &key, &value))
-    ca_proplist_sets (pl, key, value);
+  filename = g_hash_table_lookup (attrs, GSOUND_ATTR_MEDIA_FILENAME);
+  if (!filename &&
+      g_hash_table_contains (attrs, GSOUND_ATTR_GSOUND_TONE_FREQUENCY))
+    {
+      char *description;
 
-  g_hash_table_unref (ht);
-}
+      if (!gsound_tone_parse (&tone,
+                              g_hash_table_lookup (attrs, GSOUND_ATTR_GSOUND_TONE_FREQUENCY),
+                              g_hash_table_lookup (attrs, GSOUND_ATTR_GSOUND_TONE_FREQUENCY_END),
+                              g_hash_table_lookup (attrs, GSOUND_ATTR_GSOUND_TONE_WAVEFORM),
+                              g_hash_table_lookup (attrs, GSOUND_ATTR_GSOUND_TONE_DURATION),
+                              g_hash_table_lookup (attrs, GSOUND_ATTR_GSOUND_TONE_ATTACK),
+                              g_hash_table_lookup (attrs, GSOUND_ATTR_GSOUND_TONE_RELEASE),
+                              error))
+        return NULL;
 
-static int
-var_args_to_prop_list (va_list args, ca_proplist *pl)
-{
-  while (TRUE)
+      description = gsound_tone_to_string (&tone);
+      key = g_strconcat ("tone:", description, NULL);
+      g_free (description);
+    }
+  else
     {
-      const char *key;
-      const char *val;
-      int res;
+      if (!filename)
+        {
+          const char *event_id = g_hash_table_lookup (attrs, GSOUND_ATTR_EVENT_ID);
 
-      key = va_arg (args, const char*);
-      if (!key)
-        return CA_SUCCESS;
+          if (!event_id)
+            {
+              g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_INVALID,
+                                   "Timeline entry has neither a file name "
+                                   "nor an event id");
+              return NULL;
+            }
 
-      val = va_arg (args, const char*);
-      if (!val)
-        return CA_ERROR_INVALID;
+          path = gsound_clip_lookup_event (event_id,
+                                           g_hash_table_lookup (attrs, GSOUND_ATTR_CANBERRA_XDG_THEME_NAME),
+                                           g_hash_table_lookup (attrs, GSOUND_ATTR_CANBERRA_XDG_THEME_OUTPUT_PROFILE));
+          if (!path)
+            {
+              g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_NOTFOUND,
+                           "No sound found for event “%s”", event_id);
+              return NULL;
+            }
 
-      res = ca_proplist_sets (pl, key, val);
-      if (res != CA_SUCCESS)
-        return res;
+          filename = path;
+        }
+
+      key = g_strdup (filename);
     }
 
-  return CA_SUCCESS;
+  load = g_hash_table_lookup (loads, key);
+  if (load)
+    {
+      g_free (key);
+      g_free (path);
+      return load;
+    }
+
+  load = g_slice_new0 (GSoundClipLoad);
+  load->key = key;
+  load->filename = path ? path : g_strdup (filename);
+  load->tone = tone;
+  load->rate = rate;
+  g_hash_table_insert (loads, key, load);
+
+  return load;
 }
 
+/* Runs on the shared pool, see gsound_context_run_loads() */
 static void
-on_ca_play_full_finished (ca_context *ca,
-                          guint32     id,
-                          int         error_code,
-                          gpointer    user_data)
+gsound_clip_load_func (gpointer item,
+                       gpointer user_data)
 {
-  GTask *task = user_data;
+  GSoundClipLoad *load = item;
+  GCancellable *cancellable = user_data;
 
-  if (error_code != CA_SUCCESS)
+  if (g_cancellable_set_error_if_cancelled (cancellable, &load->error))
+    return;
+
+  if (load->cached)
     {
-      g_task_return_new_error (task,
-                               GSOUND_ERROR,
-                               error_code,
-                               "%s",
-                               ca_strerror (error_code));
+      if (load->rate)
+        {
+          gint64 start = g_get_monotonic_time ();
+
+          load->clip = gsound_cached_clip_unpack (load->cached, load->rate,
+                                                  &load->error);
+          load->unpack_time = g_get_monotonic_time () - start;
+        }
+      return;
+    }
+
+  if (!load->rate)
+    {
+      load->cached = gsound_cached_clip_load (load->filename, &load->tone,
+                                              load->storage, &load->error);
+      return;
     }
+
+  if (load->filename)
+    load->clip = gsound_clip_load (load->filename, &load->error);
   else
-    g_task_return_boolean (task, TRUE);
+    load->clip = gsound_tone_render (&load->tone, load->rate);
 
-  g_object_unref (task);
+  if (load->clip)
+    {
+      GSoundClip *clip = gsound_clip_resample (load->clip, load->rate);
+
+      gsound_clip_unref (load->clip);
+      load->clip = clip;
+    }
 }
 
+/* Decodes and converts the clips of @loads in parallel, starting from
+ * those preloaded into the context where possible */
 static void
-on_cancellable_cancelled (GCancellable  *cancellable,
-                          GSoundContext *self)
+gsound_context_run_loads (GSoundContext *self,
+                          GHashTable    *loads,
+                          GCancellable  *cancellable)
 {
-  ca_context_cancel (self->ca, g_direct_hash (cancellable));
+  GSoundContext *root = gsound_context_get_root (self);
+  GPtrArray *items = g_ptr_array_sized_new (g_hash_table_size (loads));
+  GHashTableIter iter;
+  GSoundClipLoad *load;
+  gint64 unpack_time = 0;
+  guint i;
+
+  g_mutex_lock (&root->lock);
+  g_hash_table_iter_init (&iter, loads);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &load))
+    {
+      GSoundCachedClip *cached = g_hash_table_lookup (root->clips, load->key);
+
+      if (cached)
+        load->cached = gsound_cached_clip_ref (cached);
+
+      g_ptr_array_add (items, load);
+    }
+  g_mutex_unlock (&root->lock);
+
+  gsound_pool_run (gsound_clip_load_func, items->pdata, items->len,
+                   cancellable);
+
+  for (i = 0; i < items->len; i++)
+    {
+      load = g_ptr_array_index (items, i);
+      unpack_time += load->unpack_time;
+    }
+
+  g_mutex_lock (&root->lock);
+  root->stats.cache_decode_time += unpack_time;
+  g_mutex_unlock (&root->lock);
+
+  g_ptr_array_unref (items);
 }
 
 /**
- * gsound_context_new:
- * @cancellable: (allow-none): A #GCancellable, or %NULL
- * @error: Return location for error
- *
- * Creates and initializes a new #GSoundContext. If the an error occured
- * during initialization, #NULL is returned and @error will be set
- * appropriately.
+ * gsound_context_set_group_volume:
+ * @context: A #GSoundContext
+ * @group: A group name, as passed in #GSOUND_ATTR_GSOUND_GROUP
+ * @volume: Volume adjustment in dB
  *
- * Returns: (transfer full): A new #GSoundContext
+ * Sets a volume adjustment which is added to #GSOUND_ATTR_CANBERRA_VOLUME
+ * for every subsequent sound played in @group. The default is 0 dB.
  */
-GSoundContext *
-gsound_context_new (GCancellable *cancellable, GError **error)
+void
+gsound_context_set_group_volume (GSoundContext *self,
+                                 const char    *group,
+                                 double         volume)
 {
-  return GSOUND_CONTEXT (g_initable_new (GSOUND_TYPE_CONTEXT,
-                                         cancellable,
-                                         error,
-                                         NULL));
+  GSoundGroup *info;
+
+  g_return_if_fail (GSOUND_IS_CONTEXT (self));
+  g_return_if_fail (group != NULL);
+
+  self = gsound_context_get_root (self);
+
+  g_mutex_lock (&self->lock);
+  info = gsound_context_ensure_group (self, group);
+  info->volume = volume;
+  gsound_context_release_group (self, info);
+  g_mutex_unlock (&self->lock);
 }
 
 /**
- * gsound_context_open:
+ * gsound_context_set_group_max_voices:
  * @context: A #GSoundContext
- * @error: Return location for error
- *
- * Attempts to open a connection to the backend sound driver. It is recommended
- * that you set context attributes with gsound_context_set_attributes() before
- * calling this function.
- *
- * > A connection is automatically opened before playing or caching sounds,
- * > so you rarely need to call this yourself.
+ * @group: A group name, as passed in #GSOUND_ATTR_GSOUND_GROUP
+ * @max_voices: Maximum number of simultaneous sounds, or 0 for no limit
  *
- * Returns: %TRUE if the output device was opened successfully, or %FALSE
- *          (populating @error)
+ * Limits the number of sounds in @group which may play at the same time.
+ * When a new sound would exceed the limit, the oldest sounds in the group
+ * are cancelled to make room for it.
  */
-gboolean
-gsound_context_open (GSoundContext *self, GError **error)
+void
+gsound_context_set_group_max_voices (GSoundContext *self,
+                                     const char    *group,
+                                     guint          max_voices)
 {
-  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), FALSE);
+  GSoundGroup *info;
+
+  g_return_if_fail (GSOUND_IS_CONTEXT (self));
+  g_return_if_fail (group != NULL);
+
+  self = gsound_context_get_root (self);
 
-  return test_return (ca_context_open (self->ca), error);
+  g_mutex_lock (&self->lock);
+  info = gsound_context_ensure_group (self, group);
+  info->max_voices = max_voices;
+  gsound_context_release_group (self, info);
+  g_mutex_unlock (&self->lock);
 }
 
 /**
- * gsound_context_set_driver:
+ * gsound_context_set_group_ducking:
  * @context: A #GSoundContext
- * @driver: libcanberra driver to use
- * @error: Return location for error, or %NULL
- *
- * Sets the libcanberra driver to @driver, for example "pulse", "alsa" or "null".
- * You normally do not need to set this yourself.
+ * @group: The group to be ducked
+ * @trigger: The group whose sounds cause @group to be ducked
+ * @attenuation: Attenuation in dB, or 0 to remove the ducking rule
  *
- * Note that this function may return %TRUE even if the specified driver is
- * not available: see the libcanberra documentation for details.
+ * Arranges for sounds in @group to be played @attenuation dB quieter while
+ * any sound in @trigger is playing, for example to duck "ambient" sounds
+ * under "alerts".
  *
- * Returns: %TRUE if the libcanberra driver was set successfully
+ * As libcanberra cannot change the volume of a sound once it has started,
+ * ducking applies to sounds which start while @trigger is playing.
  */
-gboolean
-gsound_context_set_driver (GSoundContext *self,
-                           const char    *driver,
-                           GError       **error)
+void
+gsound_context_set_group_ducking (GSoundContext *self,
+                                  const char    *group,
+                                  const char    *trigger,
+                                  double         attenuation)
 {
-  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), FALSE);
+  GSoundDucking *ducking = NULL;
+  guint i;
 
-  return test_return (ca_context_set_driver (self->ca, driver), error);
+  g_return_if_fail (GSOUND_IS_CONTEXT (self));
+  g_return_if_fail (group != NULL);
+  g_return_if_fail (trigger != NULL);
+
+  self = gsound_context_get_root (self);
+
+  g_mutex_lock (&self->lock);
+
+  for (i = 0; i < self->duckings->len; i++)
+    {
+      GSoundDucking *d = g_ptr_array_index (self->duckings, i);
+
+      if (strcmp (d->group, group) == 0 && strcmp (d->trigger, trigger) == 0)
+        {
+          ducking = d;
+          break;
+        }
+    }
+
+  if (attenuation == 0.0)
+    {
+      if (ducking)
+        g_ptr_array_remove_index_fast (self->duckings, i);
+    }
+  else
+    {
+      if (!ducking)
+        {
+          ducking = g_slice_new0 (GSoundDucking);
+          ducking->group = g_strdup (group);
+          ducking->trigger = g_strdup (trigger);
+          g_ptr_array_add (self->duckings, ducking);
+        }
+
+      ducking->attenuation = attenuation;
+    }
+
+  g_mutex_unlock (&self->lock);
 }
 
 /**
- * gsound_context_set_attributes: (skip)
+ * gsound_context_render:
  * @context: A #GSoundContext
+ * @timeline: (element-type GLib.HashTable(utf8,utf8)): Attribute sets to
+ *   render, one per sound
+ * @rate: Output sample rate in Hz, at most 384000
+ * @channels: Number of output channels, between 1 and 8
+ * @cancellable: (allow-none): A #GCancellable, or %NULL
  * @error: Return location for error
- * @...: %NULL terminated list of attribute name-value pairs
  *
- * Set attributes or change attributes on @context. Subsequent calls to this
- * function calling the same attributes will override the earlier values.
+ * Mixes the sounds described by @timeline offline, as fast as possible and
+ * without using the sound server. Each element of @timeline is a table of
+ * attributes such as would be passed to gsound_context_play_simplev(). The
+ * sound is taken from #GSOUND_ATTR_MEDIA_FILENAME or looked up in the sound
+ * theme from #GSOUND_ATTR_EVENT_ID, placed at #GSOUND_ATTR_GSOUND_RENDER_OFFSET
+ * and scaled by #GSOUND_ATTR_CANBERRA_VOLUME. Sounds are panned between the
+ * left and right channels according to #GSOUND_ATTR_EVENT_MOUSE_HPOS, or
+ * failing that #GSOUND_ATTR_WINDOW_HPOS, as sound servers may do when
+ * playing them; centred sounds are left as they are. Entries with
+ * #GSOUND_ATTR_CANBERRA_ENABLE set to "0" are skipped. A sound may be
+ * cancelled part way through with #GSOUND_ATTR_GSOUND_RENDER_CANCEL, in
+ * which case it fades out as described by
+ * #GSoundContext:render-fade-out. The volume of a sound's
+ * #GSOUND_ATTR_GSOUND_GROUP is applied, but voice limits and ducking are
+ * not.
  *
- * Note that GSound will set the #GSOUND_ATTR_APPLICATION_NAME and
- * #GSOUND_ATTR_APPLICATION_ID for you if using #GApplication, so you do
- * not normally need to set these yourself.
+ * WAV files are always supported, and Ogg Vorbis and FLAC files when GSound
+ * was built with them, along with tones synthesized as described by
+ * #GSOUND_ATTR_GSOUND_TONE_FREQUENCY.
  *
- * Returns: %TRUE if attributes were updated successfully
+ * Sounds preloaded with gsound_context_preload() are used as they are, or
+ * decoded again if kept compressed, and others are decoded in parallel
+ * before mixing starts.
+ *
+ * The result is deterministic for a given timeline and set of files.
+ *
+ * Returns: (transfer full): interleaved signed 16-bit little-endian samples,
+ *   or %NULL (populating @error)
  */
-gboolean
-gsound_context_set_attributes (GSoundContext *self,
-                               GError       **error,
-                               ...)
+GBytes *
+gsound_context_render (GSoundContext *self,
+                       GPtrArray     *timeline,
+                       guint          rate,
+                       guint          channels,
+                       GCancellable  *cancellable,
+                       GError       **error)
 {
-  ca_proplist *pl;
-  va_list args;
-  int res;
+  GSoundMixer *mixer = NULL;
+  GSoundClipLoad **entry_loads;
+  GSoundVoice *voices;
+  GHashTable *loads;
+  GBytes *bytes = NULL;
+  guint i;
 
-  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), FALSE);
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), NULL);
+  g_return_val_if_fail (timeline != NULL, NULL);
+  g_return_val_if_fail (rate > 0 && rate <= MAX_RENDER_RATE, NULL);
+  g_return_val_if_fail (channels > 0 && channels <= 8, NULL);
 
-  if ((res = ca_proplist_create (&pl)) != CA_SUCCESS)
-    return test_return (res, error);
+  loads = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+                                 (GDestroyNotify) gsound_clip_load_free);
+  entry_loads = g_new0 (GSoundClipLoad *, timeline->len);
+  voices = g_new (GSoundVoice, timeline->len);
 
-  va_start (args, error);
-  var_args_to_prop_list (args, pl);
-  va_end (args);
+  /* Work out which sounds are needed up front, so that they can be
+   * decoded in parallel before mixing */
+  for (i = 0; i < timeline->len; i++)
+    {
+      GHashTable *attrs = g_ptr_array_index (timeline, i);
+      GSoundVoice voice = GSOUND_VOICE_INIT;
+      const char *group;
 
-  res = ca_context_change_props_full (self->ca, pl);
+      if (g_cancellable_set_error_if_cancelled (cancellable, error))
+        goto out;
 
-  g_clear_pointer (&pl, ca_proplist_destroy);
+      if (g_strcmp0 (g_hash_table_lookup (attrs, GSOUND_ATTR_CANBERRA_ENABLE), "0") == 0)
+        continue;
 
-  return test_return (res, error);
+      if (!parse_render_entry (self, attrs, rate, &voice, error))
+        goto out;
+
+      if ((group = g_hash_table_lookup (attrs, GSOUND_ATTR_GSOUND_GROUP)))
+        {
+          GSoundContext *root = gsound_context_get_root (self);
+          GSoundGroup *g;
+
+          g_mutex_lock (&root->lock);
+          g = g_hash_table_lookup (root->groups, group);
+          if (g)
+            voice.gain *= powf (10.0f, (float) g->volume / 20.0f);
+          g_mutex_unlock (&root->lock);
+        }
+
+      entry_loads[i] = gsound_clip_load_resolve (attrs, loads, rate, error);
+      if (!entry_loads[i])
+        goto out;
+
+      voices[i] = voice;
+    }
+
+  gsound_context_run_loads (self, loads, cancellable);
+
+  mixer = gsound_mixer_new (rate, channels);
+
+  for (i = 0; i < timeline->len; i++)
+    {
+      GSoundClipLoad *load = entry_loads[i];
+      gsize n_frames, n_bytes;
+
+      if (!load)
+        continue;
+
+      if (load->error)
+        {
+          g_propagate_error (error, g_error_copy (load->error));
+          goto out;
+        }
+
+      /* The mixer grows to the end of every sound, doubling its buffer as
+       * it goes */
+      if (!g_size_checked_add (&n_frames, voices[i].offset,
+                               load->clip->n_frames) ||
+          !g_size_checked_mul (&n_bytes, n_frames,
+                               2 * channels * sizeof (float)))
+        {
+          g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_INVALID,
+                               "The rendered output would be too large");
+          goto out;
+        }
+
+      gsound_mixer_add (mixer, load->clip, &voices[i]);
+    }
+
+  bytes = gsound_mixer_to_s16 (mixer);
+
+out:
+  g_clear_pointer (&mixer, gsound_mixer_free);
+  g_hash_table_unref (loads);
+  g_free (entry_loads);
+  g_free (voices);
+
+  return bytes;
+}
+
+/* Finds the index of @cache_control in cache_classes, or -1 */
+static int
+cache_class_from_string (const char *cache_control)
+{
+  guint i;
+
+  for (i = 0; i < N_CACHE_CLASSES; i++)
+    if (g_strcmp0 (cache_control, cache_classes[i]) == 0)
+      return i;
+
+  return -1;
+}
+
+/* Finds how a sound with @attrs is to be kept by gsound_context_preload() */
+static GSoundCacheStorage
+gsound_context_get_cache_storage (GSoundContext *root,
+                                  GHashTable    *attrs)
+{
+  GSoundCacheStorage storage;
+  int class;
+
+  class = cache_class_from_string (g_hash_table_lookup (attrs, GSOUND_ATTR_CANBERRA_CACHE_CONTROL));
+
+  g_mutex_lock (&root->lock);
+  storage = root->cache_storage[MAX (class, 0)];
+  g_mutex_unlock (&root->lock);
+
+  return storage;
 }
 
 /**
- * gsound_context_set_attributesv: (rename-to gsound_context_set_attributes)
+ * gsound_context_preload:
  * @context: A #GSoundContext
- * @attrs: (element-type utf8 utf8): Hash table of attributes to set
- * @error: Return location for error, or %NULL
+ * @sounds: (element-type GLib.HashTable(utf8,utf8)): Attribute sets
+ *   describing the sounds to load, one per sound
+ * @cancellable: (allow-none): A #GCancellable, or %NULL
+ * @error: Return location for error
  *
- * Set attributes or change attributes on @context. Subsequent calls to this
- * function calling the same attributes will override the earlier values.
+ * Decodes the sounds described by @sounds ahead of time and keeps them in
+ * memory for gsound_context_render(). Sounds are identified as for
+ * gsound_context_render(), and are decoded in parallel on a shared pool of
+ * threads, one per processor unless the `GSOUND_THREADS` environment
+ * variable gives another number.
  *
- * Note that GSound will set the #GSOUND_ATTR_APPLICATION_NAME and
- * #GSOUND_ATTR_APPLICATION_ID for you if using #GApplication, so you do
- * not normally need to set these yourself.
- * 
- * This function is intented to be used by language bindings.
+ * gsound_context_render() also decodes the sounds of a timeline in
+ * parallel, but only keeps them for the duration of the call. Preloaded
+ * sounds are kept until the context is finalized, decoded or compressed
+ * according to their #GSOUND_ATTR_CANBERRA_CACHE_CONTROL, see
+ * gsound_context_set_cache_storage(). Sounds already preloaded are not
+ * loaded again.
  *
- * Returns: %TRUE if attributes were updated successfully
+ * Returns: %TRUE if every sound was loaded, or %FALSE (populating @error
+ *   with the first failure, in the order of @sounds)
  */
 gboolean
-gsound_context_set_attributesv (GSoundContext *self,
-                                GHashTable    *attrs,
-                                GError       **error)
+gsound_context_preload (GSoundContext *self,
+                        GPtrArray     *sounds,
+                        GCancellable  *cancellable,
+                        GError       **error)
 {
-  ca_proplist *pl;
-  int res;
+  GSoundContext *root;
+  GHashTable *loads;
+  GSoundClipLoad **sound_loads;
+  gboolean ret = FALSE;
+  guint i;
 
   g_return_val_if_fail (GSOUND_IS_CONTEXT (self), FALSE);
+  g_return_val_if_fail (sounds != NULL, FALSE);
 
-  res = ca_proplist_create (&pl);
-  if (!test_return (res, error))
-    return FALSE;
+  root = gsound_context_get_root (self);
+  loads = g_hash_table_new_full (g_str_hash, g_str_equal, NULL,
+                                 (GDestroyNotify) gsound_clip_load_free);
+  sound_loads = g_new0 (GSoundClipLoad *, sounds->len);
 
-  hash_table_to_prop_list (attrs, pl);
+  for (i = 0; i < sounds->len; i++)
+    {
+      GHashTable *attrs = g_ptr_array_index (sounds, i);
 
-  res = ca_context_change_props_full (self->ca, pl);
+      sound_loads[i] = gsound_clip_load_resolve (attrs, loads, 0, error);
+      if (!sound_loads[i])
+        goto out;
 
-  g_clear_pointer (&pl, ca_proplist_destroy);
+      sound_loads[i]->storage = gsound_context_get_cache_storage (root, attrs);
+    }
 
-  return test_return (res, error);
+  gsound_context_run_loads (self, loads, cancellable);
+
+  g_mutex_lock (&root->lock);
+  for (i = 0; i < sounds->len; i++)
+    {
+      GSoundClipLoad *load = sound_loads[i];
+
+      if (load->cached && !g_hash_table_contains (root->clips, load->key))
+        {
+          g_hash_table_insert (root->clips, g_strdup (load->key),
+                               gsound_cached_clip_ref (load->cached));
+          root->stats.cache_size += gsound_cached_clip_get_size (load->cached);
+          root->stats.cache_pcm_size += gsound_cached_clip_get_pcm_size (load->cached);
+        }
+    }
+  g_mutex_unlock (&root->lock);
+
+  for (i = 0; i < sounds->len; i++)
+    if (sound_loads[i]->error)
+      {
+        g_propagate_error (error, g_error_copy (sound_loads[i]->error));
+        goto out;
+      }
+
+  ret = TRUE;
+
+out:
+  g_hash_table_unref (loads);
+  g_free (sound_loads);
+
+  return ret;
 }
 
 /**
- * gsound_context_play_simple: (skip)
+ * gsound_context_set_cache_storage:
  * @context: A #GSoundContext
- * @cancellable: (allow-none): A #GCancellable, or %NULL
- * @error: Return location for error, or %NULL
- * @...: A %NULL-terminated list of attribute-value pairs
+ * @cache_control: A value of #GSOUND_ATTR_CANBERRA_CACHE_CONTROL:
+ *   "permanent", "volatile" or "never"
+ * @storage: How to keep sounds of @cache_control
  *
- * The basic "fire-and-forget" play command. This function will not block, and
- * just sends a request to the sound server before immediately returning.
- *
- * If you need to know when a sound finishes playing then you should call
- * gsound_context_play_full() instead.
+ * Chooses how gsound_context_preload() keeps sounds whose
+ * #GSOUND_ATTR_CANBERRA_CACHE_CONTROL is @cache_control in memory. Sounds
+ * without the attribute count as "permanent". The default for every class
+ * is %GSOUND_CACHE_STORAGE_PCM, which renders fastest.
  *
- * You can cancel playback at any time by calling g_cancellable_cancel() on
- * @cancellable, if supplied. 
+ * On devices short of memory, %GSOUND_CACHE_STORAGE_ADPCM or
+ * %GSOUND_CACHE_STORAGE_ORIGINAL shrink the cache at the cost of decoding
+ * sounds each time gsound_context_render() uses them, into a buffer reused
+ * between sounds. #GSoundStats.cache_size and #GSoundStats.cache_pcm_size
+ * give the memory saved, and #GSoundStats.cache_decode_time the time it
+ * costs.
  *
- * Returns: %TRUE on success, or %FALSE, populating @error
+ * This only affects sounds preloaded afterwards.
  */
-gboolean
-gsound_context_play_simple (GSoundContext *self,
-                            GCancellable  *cancellable,
-                            GError       **error,
-                            ...)
+void
+gsound_context_set_cache_storage (GSoundContext      *self,
+                                  const char         *cache_control,
+                                  GSoundCacheStorage  storage)
 {
-  ca_proplist *pl;
-  va_list args;
-  int res;
-
-  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), FALSE);
-
-  if ((res = ca_proplist_create (&pl)) != CA_SUCCESS)
-    return test_return (res, error);
-
-  va_start (args, error);
-  var_args_to_prop_list (args, pl);
-  va_end (args);
+  int class;
 
-  res = ca_context_play_full (self->ca,
-                              g_direct_hash (cancellable),
-                              pl, NULL, NULL);
+  g_return_if_fail (GSOUND_IS_CONTEXT (self));
+  g_return_if_fail (cache_control != NULL);
+  g_return_if_fail (storage <= GSOUND_CACHE_STORAGE_ORIGINAL);
 
-  if (cancellable)
-    g_cancellable_connect (cancellable,
-                           G_CALLBACK (on_cancellable_cancelled),
-                           g_object_ref (self),
-                           g_object_unref);
+  class = cache_class_from_string (cache_control);
+  g_return_if_fail (class >= 0);
 
-  g_clear_pointer (&pl, ca_proplist_destroy);
+  self = gsound_context_get_root (self);
 
-  return test_return (res, error);
+  g_mutex_lock (&self->lock);
+  self->cache_storage[class] = storage;
+  g_mutex_unlock (&self->lock);
 }
 
 /**
- * gsound_context_play_simplev: (rename-to gsound_context_play_simple)
+ * gsound_context_render_to_file:
  * @context: A #GSoundContext
- * @attrs: (element-type utf8 utf8): Attributes
- * @cancellable: (allow-none): A #GCancellable
+ * @timeline: (element-type GLib.HashTable(utf8,utf8)): Attribute sets to
+ *   render, one per sound
+ * @rate: Output sample rate in Hz, at most 384000
+ * @channels: Number of output channels, between 1 and 8
+ * @file: The WAV file to write
+ * @cancellable: (allow-none): A #GCancellable, or %NULL
  * @error: Return location for error
  *
- * The basic "fire-and-forget" play command. This function will not block, and
- * just sends a request to the sound server before immediately returning.
- *
- * If you need to know when a sound finishes playing then you should call
- * gsound_context_play_full() instead.
- *
- * You can cancel playback at any time by calling g_cancellable_cancel() on
- * @cancellable, if supplied.
- * 
- * This function is intented to be used by language bindings.
- *
- * Returns: %TRUE on success, %FALSE on error
+ * Like gsound_context_render(), but writes the result to @file as a 16-bit
+ * PCM WAV file, replacing any existing file.
  *
+ * Returns: %TRUE on success, or %FALSE (populating @error)
  */
 gboolean
-gsound_context_play_simplev (GSoundContext *self,
-                             GHashTable    *attrs,
-                             GCancellable  *cancellable,
-                             GError       **error)
+gsound_context_render_to_file (GSoundContext *self,
+                               GPtrArray     *timeline,
+                               guint          rate,
+                               guint          channels,
+                               GFile         *file,
+                               GCancellable  *cancellable,
+                               GError       **error)
 {
-  ca_proplist *pl;
-  int res = ca_proplist_create (&pl);
+  GBytes *wav;
+  GBytes *pcm;
+  gconstpointer data;
+  gsize size;
+  gboolean ret;
 
-  if (!test_return (res, error))
+  g_return_val_if_fail (G_IS_FILE (file), FALSE);
+
+  pcm = gsound_context_render (self, timeline, rate, channels,
+                               cancellable, error);
+  if (!pcm)
     return FALSE;
 
-  hash_table_to_prop_list (attrs, pl);
+  wav = gsound_clip_encode_wav (rate, channels, pcm);
+  data = g_bytes_get_data (wav, &size);
 
-  res = ca_context_play_full (self->ca,
-                              g_direct_hash (cancellable),
-                              pl, NULL, NULL);
+  ret = g_file_replace_contents (file, data, size, NULL, FALSE,
+                                 G_FILE_CREATE_NONE, NULL,
+                                 cancellable, error);
 
-  if (cancellable)
-    g_cancellable_connect (cancellable,
-                           G_CALLBACK (on_cancellable_cancelled),
-                           g_object_ref (self),
-                           g_object_unref);
+  g_bytes_unref (wav);
+  g_bytes_unref (pcm);
 
-  g_clear_pointer (&pl, ca_proplist_destroy);
+  return ret;
+}
 
-  return test_return (res, error);
+typedef struct
+{
+  GMainContext *main_context;
+  GHashTable   *cancellables;
+  guint         pending;
+} GSoundReplay;
+
+static void
+on_replay_play_finished (GObject      *object,
+                         GAsyncResult *result,
+                         gpointer      user_data)
+{
+  GSoundReplay *replay = user_data;
+  guint32 id = GPOINTER_TO_UINT (g_task_get_task_data (G_TASK (result)));
+
+  /* Failures are part of the workload, and show up in the statistics */
+  g_task_propagate_boolean (G_TASK (result), NULL);
+
+  g_hash_table_remove (replay->cancellables, GUINT_TO_POINTER (id));
+  replay->pending--;
 }
 
-/**
- * gsound_context_play_full: (skip)
- * @context: A #GSoundContext
- * @cancellable: (allow-none): A #GCancellable, or %NULL
- * @callback: (scope async): callback
- * @user_data: User data passed to @callback
- * @...: A %NULL-terminated list of attribute-value pairs
- *
- * Asynchronously request a sound to be played. When playback is finished
- * (or if an error occurs) then @callback will be called, following the
- * normal GIO async pattern.
- *
- * If playback is cancelled via @cancellable, then @callback will be called
- * with #G_IO_ERROR_CANCELLED.
- *
- * If you do not need notification of when playback is complete, you should
- * use gsound_context_play_simple().
- */
-void
-gsound_context_play_full (GSoundContext      *self,
-                          GCancellable       *cancellable,
-                          GAsyncReadyCallback callback,
-                          gpointer            user_data,
-                          ...)
+static void
+gsound_context_replay_play (GSoundContext *self,
+                            GSoundReplay  *replay,
+                            guint32        id,
+                            GArray        *attrs)
 {
+  GCancellable *cancellable = g_cancellable_new ();
   GError *inner_error = NULL;
-  ca_proplist *proplist;
-  va_list args;
   GTask *task;
-  int res;
 
-  task = g_task_new (self, cancellable, callback, user_data);
+  task = g_task_new (self, cancellable, on_replay_play_finished, replay);
+  g_task_set_task_data (task, GUINT_TO_POINTER (id), NULL);
 
-  res = ca_proplist_create (&proplist);
-  if (!test_return (res, &inner_error))
-    {
-      g_task_return_error (task, inner_error);
-      g_object_unref (task);
-      return;
-    }
+  g_hash_table_insert (replay->cancellables, GUINT_TO_POINTER (id),
+                       cancellable);
+  replay->pending++;
 
-  va_start (args, user_data);
-  var_args_to_prop_list (args, proplist);
-  va_end (args);
+  if (!gsound_context_submit (self, attrs, cancellable, task, &inner_error))
+    g_task_return_error (task, inner_error);
 
-  res = ca_context_play_full (self->ca,
-                              g_direct_hash (cancellable),
-                              proplist,
-                              on_ca_play_full_finished,
-                              task);
+  g_object_unref (task);
+}
 
-  if (cancellable)
-    g_cancellable_connect (cancellable,
-                           G_CALLBACK (on_cancellable_cancelled),
-                           g_object_ref (self),
-                           g_object_unref);
+static gboolean
+on_replay_timeout (gpointer user_data)
+{
+  gboolean *fired = user_data;
 
-  g_clear_pointer (&proplist, ca_proplist_destroy);
+  *fired = TRUE;
 
-  if (!test_return (res, &inner_error))
-    {
-      g_task_return_error (task, inner_error);
-      g_object_unref (task);
-    }
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+on_replay_cancelled (GCancellable *cancellable,
+                     gpointer      user_data)
+{
+  /* Only here to wake up the loop */
+  return G_SOURCE_REMOVE;
+}
+
+static void
+gsound_replay_wait_until (GSoundReplay *replay,
+                          gint64        deadline,
+                          GCancellable *cancellable)
+{
+  gint64 now = g_get_monotonic_time ();
+  gboolean fired = FALSE;
+  GSource *source;
+
+  if (deadline <= now)
+    return;
+
+  source = g_timeout_source_new ((deadline - now + 999) / 1000);
+  g_source_set_callback (source, on_replay_timeout, &fired, NULL);
+  g_source_attach (source, replay->main_context);
+
+  while (!fired && !g_cancellable_is_cancelled (cancellable))
+    g_main_context_iteration (replay->main_context, TRUE);
+
+  g_source_destroy (source);
+  g_source_unref (source);
 }
 
 /**
- * gsound_context_play_fullv: (rename-to gsound_context_play_full)
+ * gsound_context_replay:
  * @context: A #GSoundContext
- * @attrs: (element-type utf8 utf8): Attributes
+ * @file: A recording made with `GSOUND_RECORD`
+ * @speed: Playback rate relative to the recording, or 0 to issue the calls
+ *   as fast as possible
  * @cancellable: (allow-none): A #GCancellable, or %NULL
- * @callback: (scope async): callback
- * @user_data: user_data
+ * @error: Return location for error
  *
- * Asynchronously request a sound to be played. When playback is finished
- * (or if an error occurs) then @callback will be called, following the
- * normal GIO async pattern.
+ * Re-issues the play, cache and cancel calls captured in a recording on
+ * @context, keeping their relative timing scaled by @speed, and waits for
+ * all the replayed sounds to finish.
  *
- * If playback is cancelled via @cancellable, then @callback will be called
- * with #G_IO_ERROR_CANCELLED.
+ * A recording is made by setting the `GSOUND_RECORD` environment variable
+ * to the name of a file, to which GSound then logs every call made on any
+ * context in the process. Replaying a recording against different backends
+ * or versions of GSound, and comparing the statistics from
+ * gsound_context_get_stats() afterwards, gives a reproducible measure of
+ * throughput and latency for real sound traffic.
  *
- * If you do not need notification of when playback is complete, you should
- * use gsound_context_play_simple().
- * 
- * This function is intented to be used by language bindings.
+ * Errors from individual sounds do not stop the replay; they are counted in
+ * the context's statistics as they would have been originally.
+ *
+ * Returns: %TRUE on success, or %FALSE if the recording could not be read
+ *   or the replay was cancelled
  */
-void
-gsound_context_play_fullv (GSoundContext      *self,
-                           GHashTable         *attrs,
-                           GCancellable       *cancellable,
-                           GAsyncReadyCallback callback,
-                           gpointer            user_data)
+gboolean
+gsound_context_replay (GSoundContext *self,
+                       GFile         *file,
+                       double         speed,
+                       GCancellable  *cancellable,
+                       GError       **error)
 {
+  GSoundReplay replay = { NULL, };
+  GSoundRecordReader *reader;
+  GSoundRecordEntry entry;
   GError *inner_error = NULL;
-  ca_proplist *proplist;
-  GTask *task;
-  int res;
+  GSource *cancel_source;
+  GHashTableIter iter;
+  gpointer value;
+  GBytes *bytes;
+  char *contents;
+  gsize length;
+  gint64 start;
+  guint i;
 
-  task = g_task_new (self, cancellable, callback, user_data);
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), FALSE);
+  g_return_val_if_fail (G_IS_FILE (file), FALSE);
+  g_return_val_if_fail (speed >= 0.0, FALSE);
+
+  if (!g_file_load_contents (file, cancellable, &contents, &length,
+                             NULL, error))
+    return FALSE;
+
+  bytes = g_bytes_new_take (contents, length);
+  reader = gsound_record_reader_new (bytes, error);
+  g_bytes_unref (bytes);
+
+  if (!reader)
+    return FALSE;
 
-  res = ca_proplist_create (&proplist);
-  if (!test_return (res, &inner_error))
+  replay.main_context = g_main_context_new ();
+  replay.cancellables = g_hash_table_new_full (NULL, NULL, NULL,
+                                               g_object_unref);
+  g_main_context_push_thread_default (replay.main_context);
+
+  cancel_source = g_cancellable_source_new (cancellable);
+  g_source_set_callback (cancel_source, G_SOURCE_FUNC (on_replay_cancelled),
+                         NULL, NULL);
+  g_source_attach (cancel_source, replay.main_context);
+
+  start = g_get_monotonic_time ();
+
+  while (!g_cancellable_is_cancelled (cancellable) &&
+         gsound_record_reader_next (reader, &entry, &inner_error))
     {
-      g_task_return_error (task, inner_error);
-      g_object_unref (task);
-      return;
+      GCancellable *play_cancellable;
+      GArray *attrs;
+
+      if (speed > 0.0)
+        gsound_replay_wait_until (&replay, start + entry.time / speed,
+                                  cancellable);
+
+      if (g_cancellable_is_cancelled (cancellable))
+        break;
+
+      attrs = attrs_new ();
+      for (i = 0; i < entry.n_attrs; i++)
+        {
+          GSoundAttr attr = { attr_intern (entry.attrs[2 * i]),
+                              entry.attrs[2 * i + 1] };
+
+          g_array_append_val (attrs, attr);
+        }
+
+      switch (entry.op)
+        {
+        case GSOUND_RECORD_PLAY:
+          gsound_context_replay_play (self, &replay, entry.id, attrs);
+          break;
+
+        case GSOUND_RECORD_CACHE:
+          gsound_context_cache_attrs (self, attrs, NULL);
+          break;
+
+        case GSOUND_RECORD_CANCEL:
+          play_cancellable = g_hash_table_lookup (replay.cancellables,
+                                                  GUINT_TO_POINTER (entry.id));
+          if (play_cancellable)
+            g_cancellable_cancel (play_cancellable);
+          break;
+
+        case GSOUND_RECORD_CANCEL_MATCHING:
+          gsound_context_cancel_matching_attrs (self, attrs, NULL);
+          break;
+        }
+
+      attrs_free (attrs);
+
+      /* Collect completions as we go */
+      while (g_main_context_iteration (replay.main_context, FALSE))
+        ;
     }
 
-  hash_table_to_prop_list (attrs, proplist);
+  if (g_cancellable_is_cancelled (cancellable))
+    {
+      g_hash_table_iter_init (&iter, replay.cancellables);
+      while (g_hash_table_iter_next (&iter, NULL, &value))
+        g_cancellable_cancel (value);
+    }
 
-  res = ca_context_play_full (self->ca,
-                              g_direct_hash (cancellable),
-                              proplist,
-                              on_ca_play_full_finished,
-                              task);
+  while (replay.pending > 0)
+    g_main_context_iteration (replay.main_context, TRUE);
 
-  if (cancellable)
-    g_cancellable_connect (cancellable,
-                           G_CALLBACK (on_cancellable_cancelled),
-                           g_object_ref (self),
-                           g_object_unref);
+  g_source_destroy (cancel_source);
+  g_source_unref (cancel_source);
 
-  g_clear_pointer (&proplist, ca_proplist_destroy);
+  g_main_context_pop_thread_default (replay.main_context);
+  g_main_context_unref (replay.main_context);
+  g_hash_table_unref (replay.cancellables);
+  gsound_record_reader_free (reader);
 
-  if (!test_return (res, &inner_error))
+  if (inner_error)
     {
-      g_task_return_error (task, inner_error);
-      g_object_unref (task);
+      g_propagate_error (error, inner_error);
+      return FALSE;
     }
+
+  return !g_cancellable_set_error_if_cancelled (cancellable, error);
 }
 
 /**
- * gsound_context_play_full_finish:
+ * gsound_context_get_render_fade_out:
  * @context: A #GSoundContext
- * @result: Result object passed to the callback of
- *   gsound_context_play_full()
- * @error: Return location for error
  *
- * Finish an async operation started by gsound_context_play_full(). You
- * must call this function in the callback to free memory and receive any
- * errors which occurred.
+ * Gets the value of #GSoundContext:render-fade-out.
  *
- * Returns: %TRUE if playing finished successfully
+ * Returns: the fade-out duration in milliseconds
  */
-gboolean
-gsound_context_play_full_finish (GSoundContext *self,
-                                 GAsyncResult  *result,
-                                 GError       **error)
+guint
+gsound_context_get_render_fade_out (GSoundContext *self)
 {
-  g_return_val_if_fail (g_task_is_valid (result, self), FALSE);
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), 0);
 
-  return g_task_propagate_boolean (G_TASK (result), error);
+  return self->render_fade_out;
 }
 
 /**
- * gsound_context_cache: (skip)
+ * gsound_context_set_render_fade_out:
  * @context: A #GSoundContext
- * @error: Return location for error
- * @...: A %NULL-terminated list of attribute-value pairs
+ * @fade_out: fade-out duration in milliseconds
  *
- * Requests that a sound be cached on the server. See [#caching][gsound-GSound-Context#caching].
+ * Sets #GSoundContext:render-fade-out.
+ */
+void
+gsound_context_set_render_fade_out (GSoundContext *self,
+                                    guint          fade_out)
+{
+  g_return_if_fail (GSOUND_IS_CONTEXT (self));
+
+  if (self->render_fade_out == fade_out)
+    return;
+
+  self->render_fade_out = fade_out;
+  g_object_notify_by_pspec (G_OBJECT (self),
+                            properties[PROP_RENDER_FADE_OUT]);
+}
+
+/**
+ * gsound_context_get_timeout:
+ * @context: A #GSoundContext
  *
- * Returns: %TRUE on success
+ * Gets the value of #GSoundContext:timeout.
+ *
+ * Returns: the timeout in milliseconds, or 0 if sounds never time out
  */
-gboolean
-gsound_context_cache (GSoundContext *self,
-                      GError       **error,
-                      ...)
+guint
+gsound_context_get_timeout (GSoundContext *self)
 {
-  ca_proplist *pl;
-  va_list args;
-  int res;
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), 0);
 
-  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), FALSE);
+  return self->timeout;
+}
 
-  if ((res = ca_proplist_create (&pl)) != CA_SUCCESS)
-    return test_return (res, error);
+/**
+ * gsound_context_set_timeout:
+ * @context: A #GSoundContext
+ * @timeout: timeout in milliseconds, or 0 to disable
+ *
+ * Sets #GSoundContext:timeout.
+ */
+void
+gsound_context_set_timeout (GSoundContext *self,
+                            guint          timeout)
+{
+  g_return_if_fail (GSOUND_IS_CONTEXT (self));
 
-  va_start (args, error);
-  var_args_to_prop_list (args, pl);
-  va_end (args);
+  if (self->timeout == timeout)
+    return;
 
-  res = ca_context_cache_full (self->ca, pl);
+  self->timeout = timeout;
+  g_object_notify_by_pspec (G_OBJECT (self), properties[PROP_TIMEOUT]);
+}
 
-  g_clear_pointer (&pl, ca_proplist_destroy);
+/**
+ * gsound_context_get_output_latency:
+ * @context: A #GSoundContext
+ *
+ * Returns an estimate of the time between asking for a sound to be played
+ * and it becoming audible, for example to synchronise an animation with a
+ * sound.
+ *
+ * libcanberra does not report the latency of the output device, so this is
+ * a running average of the time taken by the sound server to accept sounds
+ * played on @context. It is the same as #GSoundStats.start_latency.
+ *
+ * Returns: the estimated latency in microseconds, or 0 if no sound has
+ *   been played yet
+ */
+gint64
+gsound_context_get_output_latency (GSoundContext *self)
+{
+  gint64 latency;
 
-  return test_return (res, error);
+  g_return_val_if_fail (GSOUND_IS_CONTEXT (self), 0);
+
+  self = gsound_context_get_root (self);
+
+  g_mutex_lock (&self->lock);
+  latency = self->stats.start_latency;
+  g_mutex_unlock (&self->lock);
+
+  return latency;
 }
 
 /**
- * gsound_context_cachev: (rename-to gsound_context_cache)
+ * gsound_context_set_qos_thresholds:
  * @context: A #GSoundContext
- * @attrs: (element-type utf8 utf8): Hash table of attrerties
- * @error: Return location for error, or %NULL
- * 
- * Requests that a sound be cached on the server. See [#caching][gsound-GSound-Context#caching].
+ * @max_latency: start latency in microseconds beyond which the sound server
+ *   is considered to be struggling, or 0 to ignore latency
+ * @max_error_rate: proportion of sounds failing, between 0 and 1, beyond
+ *   which the sound server is considered to be struggling, or 0 to ignore
+ *   errors
  *
- * This function is intented to be used by language bindings.
+ * Enables automatic load shedding. GSound keeps running averages of the
+ * time taken by the sound server to start sounds and of the proportion of
+ * sounds which fail or time out. Once either goes beyond its threshold,
+ * sounds with a #GSOUND_ATTR_GSOUND_PRIORITY of "low" are dropped without
+ * being sent to the sound server, and at twice the threshold so are those
+ * of "normal" priority, until the server has caught up. Sounds of "high"
+ * priority are always played.
+ *
+ * The current level is reported as #GSoundStats.qos_level, and the number
+ * of sounds dropped as #GSoundStats.shed. By default both thresholds are
+ * 0 and no sounds are dropped.
  */
-gboolean
-gsound_context_cachev (GSoundContext *self,
-                       GHashTable    *attrs,
-                       GError       **error)
+void
+gsound_context_set_qos_thresholds (GSoundContext *self,
+                                   gint64         max_latency,
+                                   double         max_error_rate)
 {
-  ca_proplist *proplist;
-  int res = ca_proplist_create (&proplist);
+  g_return_if_fail (GSOUND_IS_CONTEXT (self));
+  g_return_if_fail (max_latency >= 0);
+  g_return_if_fail (max_error_rate >= 0.0);
 
-  if (!test_return (res, error))
-    return FALSE;
+  self = gsound_context_get_root (self);
+
+  g_mutex_lock (&self->lock);
+  self->qos_max_latency = max_latency;
+  self->qos_max_error_rate = max_error_rate;
+  gsound_context_update_qos (self, g_get_monotonic_time ());
+  g_mutex_unlock (&self->lock);
+}
 
-  hash_table_to_prop_list (attrs, proplist);
+/**
+ * gsound_context_get_stats:
+ * @context: A #GSoundContext
+ * @stats: (out caller-allocates): Return location for the statistics
+ *
+ * Retrieves counters describing the sounds played on @context so far.
+ */
+void
+gsound_context_get_stats (GSoundContext *self,
+                          GSoundStats   *stats)
+{
+  g_return_if_fail (GSOUND_IS_CONTEXT (self));
+  g_return_if_fail (stats != NULL);
 
-  res = ca_context_cache_full (self->ca, proplist);
+  self = gsound_context_get_root (self);
 
-  g_clear_pointer (&proplist, ca_proplist_destroy);
+  g_mutex_lock (&self->lock);
+  gsound_context_update_qos (self, g_get_monotonic_time ());
+  *stats = self->stats;
+  g_mutex_unlock (&self->lock);
 
-  return test_return (res, error);
+  stats->in_flight = stats->submitted - stats->completed - stats->failed -
+                     stats->cancelled - stats->timed_out;
 }
 
 static gboolean
@@ -728,10 +4605,15 @@ gsound_context_real_init (GInitable    *initable,
                           GError      **error)
 {
   GSoundContext *self = GSOUND_CONTEXT (initable);
+  GApplication *app = g_application_get_default ();
+  GSoundAttr attr;
+  GArray *attrs;
+  gboolean ret;
   int success;
-  ca_proplist *pl;
+  guint i;
 
-  if (self->ca)
+  /* A child context uses the connection of its root */
+  if (self->ca || self->parent_context)
     return TRUE;
 
   success = ca_context_create (&self->ca);
@@ -740,22 +4622,41 @@ gsound_context_real_init (GInitable    *initable,
     return FALSE;
 
   /* Set a couple of attributes here if we can */
-  ca_proplist_create (&pl);
+  attrs = attrs_new ();
 
-  ca_proplist_sets (pl, CA_PROP_APPLICATION_NAME, g_get_application_name ());
-  if (g_application_get_default ())
-    {
-      GApplication *app = g_application_get_default ();
-      ca_proplist_sets (pl, CA_PROP_APPLICATION_ID,
-                        g_application_get_application_id (app));
-    }
+  attr.key = gsound_attr_key_to_string (GSOUND_ATTR_KEY_APPLICATION_NAME);
+  attr.value = g_get_application_name ();
+  if (attr.value)
+    g_array_append_val (attrs, attr);
 
-  success = ca_context_change_props_full (self->ca, pl);
+  attr.key = gsound_attr_key_to_string (GSOUND_ATTR_KEY_APPLICATION_ID);
+  attr.value = app ? g_application_get_application_id (app) : NULL;
+  if (attr.value)
+    g_array_append_val (attrs, attr);
 
-  g_clear_pointer (&pl, ca_proplist_destroy);
+  ret = gsound_context_change_attrs (self, attrs, error);
 
-  if (!test_return (success, error))
+  attrs_free (attrs);
+
+  if (!ret)
+    {
       g_clear_pointer (&self->ca, ca_context_destroy);
+      return FALSE;
+    }
+
+  /* Child contexts share these with their root, so only a root context,
+   * which is always initialized, needs them */
+  self->events = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                        (GDestroyNotify) gsound_event_free);
+  self->groups = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                        (GDestroyNotify) gsound_group_free);
+  self->duckings = g_ptr_array_new_with_free_func ((GDestroyNotify) gsound_ducking_free);
+  self->clips = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                       (GDestroyNotify) gsound_cached_clip_unref);
+
+  for (i = 0; i < N_INDEXED_ATTRS; i++)
+    self->index[i] = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                            (GDestroyNotify) gsound_index_bucket_free);
 
   return TRUE;
 }
@@ -764,23 +4665,163 @@ static void
 gsound_context_finalize (GObject *obj)
 {
   GSoundContext *self = GSOUND_CONTEXT (obj);
+  guint i;
+
+  if (self->root)
+    {
+      g_clear_object (&self->parent_context);
+      g_clear_object (&self->root);
+    }
 
   g_clear_pointer (&self->ca, ca_context_destroy);
+  for (i = 0; i < (guint) self->n_outputs; i++)
+    ca_context_destroy (self->outputs[i]);
+  if (self->driver_race)
+    gsound_driver_race_join (self->driver_race);
+  g_clear_pointer (&self->driver_race, gsound_driver_race_unref);
+  g_clear_pointer (&self->attributes, g_hash_table_unref);
+  g_mutex_clear (&self->attributes_lock);
+  g_clear_pointer (&self->events, g_hash_table_unref);
+  g_clear_pointer (&self->groups, g_hash_table_unref);
+  g_clear_pointer (&self->duckings, g_ptr_array_unref);
+  g_clear_pointer (&self->clips, g_hash_table_unref);
+  for (i = 0; i < N_INDEXED_ATTRS; i++)
+    g_clear_pointer (&self->index[i], g_hash_table_unref);
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->backend_cond);
 
   G_OBJECT_CLASS (gsound_context_parent_class)->finalize (obj);
 }
 
+static void
+gsound_context_get_property (GObject    *object,
+                             guint       prop_id,
+                             GValue     *value,
+                             GParamSpec *pspec)
+{
+  GSoundContext *self = GSOUND_CONTEXT (object);
+
+  switch (prop_id)
+    {
+    case PROP_RENDER_FADE_OUT:
+      g_value_set_uint (value, self->render_fade_out);
+      break;
+
+    case PROP_TIMEOUT:
+      g_value_set_uint (value, self->timeout);
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
+static void
+gsound_context_set_property (GObject      *object,
+                             guint         prop_id,
+                             const GValue *value,
+                             GParamSpec   *pspec)
+{
+  GSoundContext *self = GSOUND_CONTEXT (object);
+
+  switch (prop_id)
+    {
+    case PROP_RENDER_FADE_OUT:
+      gsound_context_set_render_fade_out (self, g_value_get_uint (value));
+      break;
+
+    case PROP_TIMEOUT:
+      gsound_context_set_timeout (self, g_value_get_uint (value));
+      break;
+
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+    }
+}
+
 static void
 gsound_context_class_init (GSoundContextClass *klass)
 {
   GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
 
   gobject_class->finalize = gsound_context_finalize;
+  gobject_class->get_property = gsound_context_get_property;
+  gobject_class->set_property = gsound_context_set_property;
+
+  /**
+   * GSoundContext:render-fade-out:
+   *
+   * Duration in milliseconds over which gsound_context_render() fades a
+   * sound cancelled with #GSOUND_ATTR_GSOUND_RENDER_CANCEL to silence
+   * rather than stopping it abruptly, which avoids audible clicks. May be
+   * overridden per sound with #GSOUND_ATTR_GSOUND_RENDER_FADE_OUT.
+   *
+   * This only applies to rendering. libcanberra offers no way to change
+   * the volume of a sound once it has been handed to the sound server, so
+   * sounds played through the server always stop at once when cancelled.
+   */
+  properties[PROP_RENDER_FADE_OUT] =
+    g_param_spec_uint ("render-fade-out",
+                       "Render fade out",
+                       "Fade-out duration of cancelled sounds in renders, in milliseconds",
+                       0, G_MAXUINT, 0,
+                       G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
+
+  /**
+   * GSoundContext:timeout:
+   *
+   * Time in milliseconds to wait for the sound server to finish a sound
+   * before giving up on it, or 0 to wait forever. When a sound times out
+   * it is cancelled, the callback of gsound_context_play_full() receives
+   * %G_IO_ERROR_TIMED_OUT and #GSoundStats.timed_out is incremented, so
+   * that a hung sound server cannot keep requests pending indefinitely.
+   *
+   * Set this comfortably above the length of the longest sound played. It
+   * may be overridden per sound with #GSOUND_ATTR_GSOUND_TIMEOUT.
+   */
+  properties[PROP_TIMEOUT] =
+    g_param_spec_uint ("timeout",
+                       "Timeout",
+                       "Time to wait for a sound to finish, in milliseconds",
+                       0, G_MAXUINT, 0,
+                       G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties (gobject_class, N_PROPS, properties);
+
+  /**
+   * GSoundContext::started:
+   * @context: The #GSoundContext
+   * @event_id: (nullable): The #GSOUND_ATTR_EVENT_ID of the sound, if any
+   * @latency: Time in microseconds between the sound being played on
+   *   @context and being started by the sound server
+   *
+   * Emitted when the sound server has accepted a sound and started playing
+   * it, which may be used to measure trigger-to-audible latency. The signal
+   * is emitted in the thread-default main context of the thread which
+   * played the sound, and only for sounds played while a handler was
+   * connected.
+   */
+  signals[STARTED] =
+    g_signal_new ("started",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0,
+                  NULL, NULL, NULL,
+                  G_TYPE_NONE,
+                  2,
+                  G_TYPE_STRING,
+                  G_TYPE_INT64);
 }
 
 static void
 gsound_context_init (GSoundContext *self)
 {
+  g_mutex_init (&self->attributes_lock);
+  self->attributes = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                            NULL, g_free);
+
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->backend_cond);
 }
 
 static void
@@ -64,11 +64,98 @@ typedef enum
     GSOUND_ERROR_FORKED = -17,
     GSOUND_ERROR_DISCONNECTED = -18
 } GSoundError;
+
+/**
+ * GSoundQosLevel:
+ * @GSOUND_QOS_NORMAL: All sounds are played
+ * @GSOUND_QOS_DEGRADED: The sound server is beyond the thresholds set with
+ *   gsound_context_set_qos_thresholds(), and low priority sounds are dropped
+ * @GSOUND_QOS_CRITICAL: The sound server is far beyond the thresholds, and
+ *   only high priority sounds are played
+ *
+ * How much a #GSoundContext is holding back to let a struggling sound
+ * server catch up, see #GSOUND_ATTR_GSOUND_PRIORITY.
+ */
+typedef enum
+{
+  GSOUND_QOS_NORMAL,
+  GSOUND_QOS_DEGRADED,
+  GSOUND_QOS_CRITICAL
+} GSoundQosLevel;
+
+/**
+ * GSoundCacheStorage:
+ * @GSOUND_CACHE_STORAGE_PCM: Sounds are kept decoded, which is fastest to
+ *   render but takes the most memory
+ * @GSOUND_CACHE_STORAGE_ADPCM: Sounds are kept as 4-bit IMA ADPCM, an
+ *   eighth of the size, and decoded again when rendered
+ * @GSOUND_CACHE_STORAGE_ORIGINAL: The sound files are kept as they are,
+ *   which for compressed formats such as Ogg Vorbis is smallest, and
+ *   decoded again when rendered
+ *
+ * How gsound_context_preload() keeps sounds in memory, trading rendering
+ * speed for memory, see gsound_context_set_cache_storage().
+ */
+typedef enum
+{
+  GSOUND_CACHE_STORAGE_PCM,
+  GSOUND_CACHE_STORAGE_ADPCM,
+  GSOUND_CACHE_STORAGE_ORIGINAL
+} GSoundCacheStorage;
+
+/**
+ * GSoundStats:
+ * @submitted: Number of sounds submitted for playing
+ * @completed: Number of sounds which finished playing successfully
+ * @failed: Number of sounds which failed with an error
+ * @cancelled: Number of sounds which were cancelled or dropped by their
+ *   retrigger policy or to reduce load
+ * @timed_out: Number of sounds which timed out, see #GSoundContext:timeout
+ * @start_latency: Running average of the time in microseconds taken by the
+ *   sound server to start a sound, see gsound_context_get_output_latency()
+ * @in_flight: Number of sounds submitted which have not finished yet,
+ *   whether playing or queued
+ * @shed: Number of sounds dropped to reduce load, which are also counted
+ *   in @cancelled
+ * @qos_level: The current #GSoundQosLevel
+ * @cache_size: Memory in bytes taken by sounds preloaded with
+ *   gsound_context_preload()
+ * @cache_pcm_size: Memory in bytes the preloaded sounds would take if
+ *   kept decoded, see #GSoundCacheStorage
+ * @cache_decode_time: Total time in microseconds spent by
+ *   gsound_context_render() getting preloaded sounds ready, decoding them
+ *   if they are kept compressed and converting them to the output rate,
+ *   summed across threads
+ *
+ * Counters describing the activity of a #GSoundContext, as returned by
+ * gsound_context_get_stats().
+ */
+typedef struct
+{
+  guint64 submitted;
+  guint64 completed;
+  guint64 failed;
+  guint64 cancelled;
+  guint64 timed_out;
+  gint64  start_latency;
+  guint64 in_flight;
+  guint64 shed;
+  GSoundQosLevel qos_level;
+  guint64 cache_size;
+  guint64 cache_pcm_size;
+  gint64  cache_decode_time;
+
+  /*< private >*/
+  guint64 padding[4];
+} GSoundStats;
+
 GType             gsound_context_get_type          (void);
 
 GSoundContext    *gsound_context_new               (GCancellable  *cancellable,
                                                     GError       **error);
 
+GSoundContext    *gsound_context_new_child         (GSoundContext  *parent);
+
 gboolean          gsound_context_open              (GSoundContext  *context,
                                                     GError        **error);
 
@@ -80,10 +167,25 @@ gboolean          gsound_context_set_attributesv   (GSoundContext  *context,
                                                     GHashTable     *attrs,
                                                     GError        **error);
 
+GHashTable       *gsound_context_get_attributes    (GSoundContext  *context);
+
 gboolean          gsound_context_set_driver        (GSoundContext  *context,
                                                     const char     *driver,
                                                     GError        **error);
 
+gboolean          gsound_context_set_drivers       (GSoundContext       *context,
+                                                    const char * const  *drivers,
+                                                    gboolean             race,
+                                                    GError             **error);
+
+gint64            gsound_context_get_open_latency  (GSoundContext  *context,
+                                                    const char     *driver);
+
+gboolean          gsound_context_add_output        (GSoundContext  *context,
+                                                    const char     *driver,
+                                                    const char     *device,
+                                                    GError        **error);
+
 gboolean          gsound_context_play_simple       (GSoundContext  *context,
                                                     GCancellable   *cancellable,
                                                     GError        **error,
@@ -94,6 +196,11 @@ gboolean          gsound_context_play_simplev      (GSoundContext  *context,
                                                     GCancellable   *cancellable,
                                                     GError        **error);
 
+gboolean          gsound_context_play_simple_keys  (GSoundContext  *context,
+                                                    GCancellable   *cancellable,
+                                                    GError        **error,
+                                                    ...);
+
 void              gsound_context_play_full         (GSoundContext       *context,
                                                     GCancellable        *cancellable,
                                                     GAsyncReadyCallback  callback,
@@ -106,6 +213,20 @@ void              gsound_context_play_fullv        (GSoundContext       *context
                                                     GAsyncReadyCallback  callback,
                                                     gpointer             user_data);
 
+void              gsound_context_play_full_keys    (GSoundContext       *context,
+                                                    GCancellable        *cancellable,
+                                                    GAsyncReadyCallback  callback,
+                                                    gpointer             user_data,
+                                                    ...);
+
+gboolean          gsound_context_cancel_matching   (GSoundContext  *context,
+                                                    GError        **error,
+                                                    ...) G_GNUC_NULL_TERMINATED;
+
+gboolean          gsound_context_cancel_matchingv  (GSoundContext  *context,
+                                                    GHashTable     *filter,
+                                                    GError        **error);
+
 gboolean          gsound_context_play_full_finish  (GSoundContext  *context,
                                                     GAsyncResult   *result,
                                                     GError        **error);
@@ -118,6 +239,68 @@ gboolean          gsound_context_cachev            (GSoundContext  *context,
                                                     GHashTable     *attrs,
                                                     GError        **error);
 
+guint             gsound_context_get_render_fade_out (GSoundContext *context);
+
+void              gsound_context_set_render_fade_out (GSoundContext *context,
+                                                      guint          fade_out);
+
+guint             gsound_context_get_timeout       (GSoundContext  *context);
+
+void              gsound_context_set_timeout       (GSoundContext  *context,
+                                                    guint           timeout);
+
+gint64            gsound_context_get_output_latency (GSoundContext *context);
+
+void              gsound_context_set_qos_thresholds (GSoundContext *context,
+                                                     gint64         max_latency,
+                                                     double         max_error_rate);
+
+void              gsound_context_get_stats         (GSoundContext  *context,
+                                                    GSoundStats    *stats);
+
+void              gsound_context_set_group_volume  (GSoundContext  *context,
+                                                    const char     *group,
+                                                    double          volume);
+
+void              gsound_context_set_group_max_voices (GSoundContext *context,
+                                                       const char    *group,
+                                                       guint          max_voices);
+
+void              gsound_context_set_group_ducking (GSoundContext  *context,
+                                                    const char     *group,
+                                                    const char     *trigger,
+                                                    double          attenuation);
+
+GBytes           *gsound_context_render            (GSoundContext  *context,
+                                                    GPtrArray      *timeline,
+                                                    guint           rate,
+                                                    guint           channels,
+                                                    GCancellable   *cancellable,
+                                                    GError        **error);
+
+gboolean          gsound_context_render_to_file    (GSoundContext  *context,
+                                                    GPtrArray      *timeline,
+                                                    guint           rate,
+                                                    guint           channels,
+                                                    GFile          *file,
+                                                    GCancellable   *cancellable,
+                                                    GError        **error);
+
+gboolean          gsound_context_preload           (GSoundContext  *context,
+                                                    GPtrArray      *sounds,
+                                                    GCancellable   *cancellable,
+                                                    GError        **error);
+
+void              gsound_context_set_cache_storage (GSoundContext      *context,
+                                                    const char         *cache_control,
+                                                    GSoundCacheStorage  storage);
+
+gboolean          gsound_context_replay            (GSoundContext  *context,
+                                                    GFile          *file,
+                                                    double          speed,
+                                                    GCancellable   *cancellable,
+                                                    GError        **error);
+
 G_END_DECLS
 #endif /* GSOUND_CONTEXT_H */
 
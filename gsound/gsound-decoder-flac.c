@@ -0,0 +1,232 @@
+/* gsound-decoder-flac.c
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gsound-decoder-private.h"
+#include "gsound-context.h"
+
+#include <FLAC/stream_decoder.h>
+
+typedef struct
+{
+  FLAC__StreamDecoder *decoder;
+  const guint8        *data;
+  gsize                length;
+  gsize                pos;
+
+  GSoundClipInfo      *info;
+  gboolean             failed;
+
+  /* The last decoded block, of which @n_pending frames from @pending_pos
+   * are still to be read */
+  float               *pending;
+  gsize                n_allocated;
+  gsize                n_pending;
+  gsize                pending_pos;
+} FlacState;
+
+static FLAC__StreamDecoderReadStatus
+flac_read_cb (const FLAC__StreamDecoder *decoder,
+              FLAC__byte                 buffer[],
+              size_t                    *bytes,
+              void                      *data)
+{
+  FlacState *state = data;
+
+  if (state->pos == state->length)
+    {
+      *bytes = 0;
+      return FLAC__STREAM_DECODER_READ_STATUS_END_OF_STREAM;
+    }
+
+  *bytes = MIN (*bytes, state->length - state->pos);
+  memcpy (buffer, state->data + state->pos, *bytes);
+  state->pos += *bytes;
+
+  return FLAC__STREAM_DECODER_READ_STATUS_CONTINUE;
+}
+
+static void
+flac_metadata_cb (const FLAC__StreamDecoder  *decoder,
+                  const FLAC__StreamMetadata *metadata,
+                  void                       *data)
+{
+  FlacState *state = data;
+  const FLAC__StreamMetadata_StreamInfo *si = &metadata->data.stream_info;
+
+  if (metadata->type != FLAC__METADATA_TYPE_STREAMINFO)
+    return;
+
+  state->info->rate = si->sample_rate;
+  state->info->channels = si->channels;
+  state->info->bits = si->bits_per_sample;
+  state->info->n_frames = si->total_samples;
+}
+
+static FLAC__StreamDecoderWriteStatus
+flac_write_cb (const FLAC__StreamDecoder *decoder,
+               const FLAC__Frame         *frame,
+               const FLAC__int32 * const  buffer[],
+               void                      *data)
+{
+  FlacState *state = data;
+  guint channels = frame->header.channels;
+  guint bits = frame->header.bits_per_sample;
+  gsize n_frames = frame->header.blocksize;
+  float scale;
+  gsize i;
+  guint c;
+
+  if (channels != state->info->channels || bits == 0 || bits > 32)
+    {
+      state->failed = TRUE;
+      return FLAC__STREAM_DECODER_WRITE_STATUS_ABORT;
+    }
+
+  if (n_frames > state->n_allocated)
+    {
+      state->pending = g_renew (float, state->pending, n_frames * channels);
+      state->n_allocated = n_frames;
+    }
+
+  scale = 1.0f / (float) (G_GUINT64_CONSTANT (1) << (bits - 1));
+
+  for (c = 0; c < channels; c++)
+    for (i = 0; i < n_frames; i++)
+      state->pending[i * channels + c] = buffer[c][i] * scale;
+
+  state->n_pending = n_frames;
+  state->pending_pos = 0;
+
+  return FLAC__STREAM_DECODER_WRITE_STATUS_CONTINUE;
+}
+
+static void
+flac_error_cb (const FLAC__StreamDecoder      *decoder,
+               FLAC__StreamDecoderErrorStatus  status,
+               void                           *data)
+{
+  FlacState *state = data;
+
+  state->failed = TRUE;
+}
+
+static gboolean
+flac_probe (const guint8 *data,
+            gsize         length)
+{
+  return length >= 4 && memcmp (data, "fLaC", 4) == 0;
+}
+
+static void
+flac_close (gpointer data)
+{
+  FlacState *state = data;
+
+  FLAC__stream_decoder_delete (state->decoder);
+  g_free (state->pending);
+  g_slice_free (FlacState, state);
+}
+
+static gpointer
+flac_open (const guint8    *data,
+           gsize            length,
+           GSoundClipInfo  *info,
+           gboolean         cached,
+           GError         **error)
+{
+  FlacState *state;
+
+  state = g_slice_new0 (FlacState);
+  state->data = data;
+  state->length = length;
+  state->info = info;
+
+  state->decoder = FLAC__stream_decoder_new ();
+  if (!state->decoder)
+    {
+      g_slice_free (FlacState, state);
+      g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_OOM,
+                           "Could not create FLAC decoder");
+      return NULL;
+    }
+
+  /* STREAMINFO always comes first; with cached information there is no
+   * need to look at the other metadata blocks */
+  if (cached)
+    FLAC__stream_decoder_set_metadata_ignore_all (state->decoder);
+
+  if (FLAC__stream_decoder_init_stream (state->decoder, flac_read_cb,
+                                        NULL, NULL, NULL, NULL,
+                                        flac_write_cb, flac_metadata_cb,
+                                        flac_error_cb, state)
+        != FLAC__STREAM_DECODER_INIT_STATUS_OK ||
+      !FLAC__stream_decoder_process_until_end_of_metadata (state->decoder) ||
+      state->failed)
+    {
+      flac_close (state);
+      g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_CORRUPT,
+                           "Not a valid FLAC file");
+      return NULL;
+    }
+
+  return state;
+}
+
+static gssize
+flac_read (gpointer   data,
+           float     *frames,
+           gsize      n_frames,
+           GError   **error)
+{
+  FlacState *state = data;
+  guint channels = state->info->channels;
+
+  while (state->n_pending == 0)
+    {
+      if (FLAC__stream_decoder_get_state (state->decoder) ==
+          FLAC__STREAM_DECODER_END_OF_STREAM)
+        return 0;
+
+      if (!FLAC__stream_decoder_process_single (state->decoder) ||
+          state->failed)
+        {
+          g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_CORRUPT,
+                               "Not a valid FLAC file");
+          return -1;
+        }
+    }
+
+  n_frames = MIN (n_frames, state->n_pending);
+  memcpy (frames, state->pending + state->pending_pos * channels,
+          n_frames * channels * sizeof (float));
+  state->pending_pos += n_frames;
+  state->n_pending -= n_frames;
+
+  return n_frames;
+}
+
+static const char * const flac_extensions[] = { ".flac", NULL };
+
+const GSoundDecoder gsound_decoder_flac = {
+  "FLAC",
+  flac_extensions,
+  flac_probe,
+  flac_open,
+  flac_read,
+  flac_close,
+};
@@ -0,0 +1,117 @@
+/* gsound-decoder-private.h
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GSOUND_DECODER_PRIVATE_H
+#define GSOUND_DECODER_PRIVATE_H
+
+#include "gsound-clip-private.h"
+
+#include <sys/stat.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GSoundDecoder GSoundDecoder;
+
+/*
+ * GSoundClipInfo:
+ * @decoder: the decoder for the file
+ * @rate: sample rate in Hz
+ * @channels: number of channels
+ * @n_frames: length in frames, or 0 if not known before decoding
+ * @offset: for formats holding raw samples, where they start in the file
+ * @size: for formats holding raw samples, their size in bytes
+ * @format: decoder-specific sample format
+ * @bits: decoder-specific sample size
+ *
+ * What a decoder learns from the header of a file, which is cached by file
+ * identity so that loading the same file again can skip parsing it.
+ */
+typedef struct
+{
+  const GSoundDecoder *decoder;
+  guint                rate;
+  guint                channels;
+  gsize                n_frames;
+  gsize                offset;
+  gsize                size;
+  guint                format;
+  guint                bits;
+} GSoundClipInfo;
+
+/*
+ * GSoundDecoder:
+ * @name: name of the format, for messages
+ * @extensions: %NULL-terminated list of file name extensions, including
+ *   the dot, in order of preference
+ * @probe: checks whether the file starting with @data is in this format
+ * @open: starts decoding the file in @data, which stays mapped until
+ *   @close. If @cached is %FALSE, fills in @info from the header; if
+ *   %TRUE, @info is as filled in by an earlier call for the same file and
+ *   need not be parsed again. Returns the decoder state, or %NULL on error.
+ * @read: decodes up to @n_frames interleaved float frames into @frames,
+ *   returning the number decoded, 0 at the end of the file or -1 on error
+ * @close: frees the decoder state
+ *
+ * A streaming decoder for one file format. Decoders work on files mapped
+ * into memory, and are kept separate from the rest of GSound so that each
+ * can be measured and optimised in isolation.
+ */
+struct _GSoundDecoder
+{
+  const char          *name;
+  const char * const  *extensions;
+
+  gboolean (*probe) (const guint8    *data,
+                     gsize            length);
+
+  gpointer (*open)  (const guint8    *data,
+                     gsize            length,
+                     GSoundClipInfo  *info,
+                     gboolean         cached,
+                     GError         **error);
+
+  gssize   (*read)  (gpointer         state,
+                     float           *frames,
+                     gsize            n_frames,
+                     GError         **error);
+
+  void     (*close) (gpointer         state);
+};
+
+extern const GSoundDecoder gsound_decoder_wav;
+#ifdef HAVE_VORBIS
+extern const GSoundDecoder gsound_decoder_vorbis;
+#endif
+#ifdef HAVE_FLAC
+extern const GSoundDecoder gsound_decoder_flac;
+#endif
+
+const GSoundDecoder * const *gsound_decoder_get_all     (void);
+
+const GSoundDecoder         *gsound_decoder_probe       (const guint8         *data,
+                                                         gsize                 length);
+
+gboolean                     gsound_decoder_info_lookup (const struct stat    *st,
+                                                         GSoundClipInfo       *info);
+
+void                         gsound_decoder_info_insert (const struct stat    *st,
+                                                         const GSoundClipInfo *info);
+
+G_END_DECLS
+
+#endif /* GSOUND_DECODER_PRIVATE_H */
@@ -0,0 +1,199 @@
+/* gsound-decoder-vorbis.c
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gsound-decoder-private.h"
+#include "gsound-context.h"
+
+#include <stdio.h>
+#include <vorbis/vorbisfile.h>
+
+typedef struct
+{
+  OggVorbis_File  file;
+  const guint8   *data;
+  gsize           length;
+  gsize           pos;
+  guint           channels;
+} VorbisState;
+
+static size_t
+vorbis_read_cb (void   *ptr,
+                size_t  size,
+                size_t  nmemb,
+                void   *data)
+{
+  VorbisState *state = data;
+  gsize n;
+
+  if (size == 0)
+    return 0;
+
+  n = MIN (nmemb, (state->length - state->pos) / size);
+  memcpy (ptr, state->data + state->pos, n * size);
+  state->pos += n * size;
+
+  return n;
+}
+
+static int
+vorbis_seek_cb (void        *data,
+                ogg_int64_t  offset,
+                int          whence)
+{
+  VorbisState *state = data;
+  gint64 pos;
+
+  switch (whence)
+    {
+    case SEEK_SET: pos = offset; break;
+    case SEEK_CUR: pos = (gint64) state->pos + offset; break;
+    case SEEK_END: pos = (gint64) state->length + offset; break;
+    default: return -1;
+    }
+
+  if (pos < 0 || (guint64) pos > state->length)
+    return -1;
+
+  state->pos = pos;
+
+  return 0;
+}
+
+static long
+vorbis_tell_cb (void *data)
+{
+  VorbisState *state = data;
+
+  return state->pos;
+}
+
+static const ov_callbacks callbacks = {
+  vorbis_read_cb,
+  vorbis_seek_cb,
+  NULL,
+  vorbis_tell_cb,
+};
+
+static gboolean
+vorbis_probe (const guint8 *data,
+              gsize         length)
+{
+  /* The first page of an Ogg Vorbis stream holds the identification
+   * header, which starts right after the 27-byte page header and the
+   * one-byte segment table */
+  return length >= 35 &&
+         memcmp (data, "OggS", 4) == 0 &&
+         memcmp (data + 28, "\001vorbis", 7) == 0;
+}
+
+static gpointer
+vorbis_open (const guint8    *data,
+             gsize            length,
+             GSoundClipInfo  *info,
+             gboolean         cached,
+             GError         **error)
+{
+  VorbisState *state;
+  vorbis_info *vi;
+  ogg_int64_t total;
+
+  state = g_slice_new0 (VorbisState);
+  state->data = data;
+  state->length = length;
+
+  /* libvorbisfile has to parse the headers to set up the decoder, cached
+   * or not */
+  if (ov_open_callbacks (state, &state->file, NULL, 0, callbacks) != 0)
+    {
+      g_slice_free (VorbisState, state);
+      g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_CORRUPT,
+                           "Not a valid Ogg Vorbis file");
+      return NULL;
+    }
+
+  vi = ov_info (&state->file, -1);
+  state->channels = vi->channels;
+
+  if (!cached)
+    {
+      total = ov_pcm_total (&state->file, -1);
+
+      info->rate = vi->rate;
+      info->channels = vi->channels;
+      info->n_frames = total > 0 ? (gsize) total : 0;
+    }
+
+  return state;
+}
+
+static gssize
+vorbis_read (gpointer   data,
+             float     *frames,
+             gsize      n_frames,
+             GError   **error)
+{
+  VorbisState *state = data;
+
+  while (TRUE)
+    {
+      float **pcm;
+      long n_read;
+      guint c;
+      long i;
+      int section;
+
+      n_read = ov_read_float (&state->file, &pcm, MIN (n_frames, G_MAXINT),
+                              &section);
+      if (n_read == OV_HOLE)
+        continue;
+
+      if (n_read < 0 ||
+          (n_read > 0 && ov_info (&state->file, section)->channels != (int) state->channels))
+        {
+          g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_CORRUPT,
+                               "Not a valid Ogg Vorbis file");
+          return -1;
+        }
+
+      for (c = 0; c < state->channels; c++)
+        for (i = 0; i < n_read; i++)
+          frames[i * state->channels + c] = pcm[c][i];
+
+      return n_read;
+    }
+}
+
+static void
+vorbis_close (gpointer data)
+{
+  VorbisState *state = data;
+
+  ov_clear (&state->file);
+  g_slice_free (VorbisState, state);
+}
+
+static const char * const vorbis_extensions[] = { ".oga", ".ogg", NULL };
+
+const GSoundDecoder gsound_decoder_vorbis = {
+  "Ogg Vorbis",
+  vorbis_extensions,
+  vorbis_probe,
+  vorbis_open,
+  vorbis_read,
+  vorbis_close,
+};
@@ -0,0 +1,254 @@
+/* gsound-decoder-wav.c
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gsound-decoder-private.h"
+#include "gsound-context.h"
+
+#define WAVE_FORMAT_PCM        0x0001
+#define WAVE_FORMAT_IEEE_FLOAT 0x0003
+#define WAVE_FORMAT_EXTENSIBLE 0xFFFE
+
+#define MAX_CHANNELS 8
+
+typedef struct
+{
+  const guint8 *pcm;
+  gsize         n_frames;
+  gsize         pos;
+  guint         channels;
+  guint         bits;
+  gboolean      is_float;
+} WavState;
+
+static inline guint16
+read_le16 (const guint8 *p)
+{
+  return (guint16) (p[0] | (p[1] << 8));
+}
+
+static inline guint32
+read_le32 (const guint8 *p)
+{
+  return (guint32) p[0] | ((guint32) p[1] << 8) |
+         ((guint32) p[2] << 16) | ((guint32) p[3] << 24);
+}
+
+static void
+convert_pcm (const guint8 *in,
+             float        *out,
+             gsize         n_samples,
+             guint         bits,
+             gboolean      is_float)
+{
+  gsize i;
+
+  if (is_float)
+    {
+      for (i = 0; i < n_samples; i++)
+        {
+          union { guint32 u; float f; } v;
+
+          v.u = read_le32 (in + i * 4);
+          out[i] = v.f;
+        }
+      return;
+    }
+
+  switch (bits)
+    {
+    case 8:
+      for (i = 0; i < n_samples; i++)
+        out[i] = ((int) in[i] - 128) * (1.0f / 128.0f);
+      break;
+
+    case 16:
+      for (i = 0; i < n_samples; i++)
+        out[i] = (gint16) read_le16 (in + i * 2) * (1.0f / 32768.0f);
+      break;
+
+    case 24:
+      for (i = 0; i < n_samples; i++)
+        {
+          const guint8 *p = in + i * 3;
+          gint32 s = (gint32) ((guint32) p[0] << 8 |
+                               (guint32) p[1] << 16 |
+                               (guint32) p[2] << 24) >> 8;
+
+          out[i] = s * (1.0f / 8388608.0f);
+        }
+      break;
+
+    case 32:
+      for (i = 0; i < n_samples; i++)
+        out[i] = (gint32) read_le32 (in + i * 4) * (1.0f / 2147483648.0f);
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+static gboolean
+wav_probe (const guint8 *data,
+           gsize         length)
+{
+  return length >= 12 &&
+         memcmp (data, "RIFF", 4) == 0 &&
+         memcmp (data + 8, "WAVE", 4) == 0;
+}
+
+static gboolean
+wav_parse (const guint8    *data,
+           gsize            length,
+           GSoundClipInfo  *info,
+           GError         **error)
+{
+  const guint8 *fmt = NULL;
+  gsize fmt_size = 0;
+  gsize pos = 12;
+  guint16 format, channels, block_align, bits;
+  guint32 rate;
+
+  info->offset = 0;
+  info->size = 0;
+
+  while (pos + 8 <= length)
+    {
+      gsize chunk_size = read_le32 (data + pos + 4);
+
+      chunk_size = MIN (chunk_size, length - pos - 8);
+
+      if (memcmp (data + pos, "fmt ", 4) == 0)
+        {
+          fmt = data + pos + 8;
+          fmt_size = chunk_size;
+        }
+      else if (memcmp (data + pos, "data", 4) == 0)
+        {
+          info->offset = pos + 8;
+          info->size = chunk_size;
+        }
+
+      pos += 8 + chunk_size + (chunk_size & 1);
+    }
+
+  if (!fmt || !info->offset || fmt_size < 16)
+    goto corrupt;
+
+  format = read_le16 (fmt);
+  channels = read_le16 (fmt + 2);
+  rate = read_le32 (fmt + 4);
+  block_align = read_le16 (fmt + 12);
+  bits = read_le16 (fmt + 14);
+
+  if (format == WAVE_FORMAT_EXTENSIBLE && fmt_size >= 26)
+    format = read_le16 (fmt + 24);
+
+  if (channels == 0 || channels > MAX_CHANNELS || rate == 0)
+    goto corrupt;
+
+  if (!(format == WAVE_FORMAT_PCM &&
+        (bits == 8 || bits == 16 || bits == 24 || bits == 32)) &&
+      !(format == WAVE_FORMAT_IEEE_FLOAT && bits == 32))
+    {
+      g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_NOTSUPPORTED,
+                           "Unsupported WAV sample format");
+      return FALSE;
+    }
+
+  if (block_align != channels * (bits / 8))
+    goto corrupt;
+
+  info->rate = rate;
+  info->channels = channels;
+  info->n_frames = info->size / block_align;
+  info->format = format;
+  info->bits = bits;
+
+  return TRUE;
+
+corrupt:
+  g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_CORRUPT,
+                       "Not a valid WAV file");
+  return FALSE;
+}
+
+static gpointer
+wav_open (const guint8    *data,
+          gsize            length,
+          GSoundClipInfo  *info,
+          gboolean         cached,
+          GError         **error)
+{
+  WavState *state;
+
+  /* With cached information the chunks need not be walked again; the
+   * samples are only checked to still be within the file */
+  if (!cached && !wav_parse (data, length, info, error))
+    return NULL;
+
+  if (info->offset > length || info->size > length - info->offset)
+    {
+      g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_CORRUPT,
+                           "Not a valid WAV file");
+      return NULL;
+    }
+
+  state = g_slice_new0 (WavState);
+  state->pcm = data + info->offset;
+  state->n_frames = info->n_frames;
+  state->channels = info->channels;
+  state->bits = info->bits;
+  state->is_float = info->format == WAVE_FORMAT_IEEE_FLOAT;
+
+  return state;
+}
+
+static gssize
+wav_read (gpointer   data,
+          float     *frames,
+          gsize      n_frames,
+          GError   **error)
+{
+  WavState *state = data;
+  gsize frame_size = state->channels * (state->bits / 8);
+
+  n_frames = MIN (n_frames, state->n_frames - state->pos);
+  convert_pcm (state->pcm + state->pos * frame_size, frames,
+               n_frames * state->channels, state->bits, state->is_float);
+  state->pos += n_frames;
+
+  return n_frames;
+}
+
+static void
+wav_close (gpointer state)
+{
+  g_slice_free (WavState, state);
+}
+
+static const char * const wav_extensions[] = { ".wav", NULL };
+
+const GSoundDecoder gsound_decoder_wav = {
+  "WAV",
+  wav_extensions,
+  wav_probe,
+  wav_open,
+  wav_read,
+  wav_close,
+};
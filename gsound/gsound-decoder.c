@@ -0,0 +1,180 @@
+/* gsound-decoder.c
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gsound-decoder-private.h"
+
+/* The probe cache is simply emptied when it fills up, as sound themes
+ * hold far fewer files than this */
+#define MAX_CACHED_INFOS 512
+
+/* In order of preference for sound theme lookups, following the XDG sound
+ * theme specification */
+static const GSoundDecoder * const decoders[] = {
+#ifdef HAVE_VORBIS
+  &gsound_decoder_vorbis,
+#endif
+  &gsound_decoder_wav,
+#ifdef HAVE_FLAC
+  &gsound_decoder_flac,
+#endif
+  NULL
+};
+
+/* Identifies a file and the version of its contents */
+typedef struct
+{
+  guint64 device;
+  guint64 inode;
+  guint64 size;
+  gint64  mtime;
+  gint64  mtime_nsec;
+} GSoundFileId;
+
+typedef struct
+{
+  GSoundFileId   id;
+  GSoundClipInfo info;
+} GSoundCachedInfo;
+
+static GMutex info_lock;
+static GHashTable *infos;
+
+/*
+ * gsound_decoder_get_all:
+ *
+ * Returns: (transfer none): the %NULL-terminated list of decoders built
+ *   into GSound
+ */
+const GSoundDecoder * const *
+gsound_decoder_get_all (void)
+{
+  return decoders;
+}
+
+/*
+ * gsound_decoder_probe:
+ * @data: the start of a file
+ * @length: the length of the file
+ *
+ * Returns: (nullable): the decoder for the file, or %NULL if its format is
+ *   not supported
+ */
+const GSoundDecoder *
+gsound_decoder_probe (const guint8 *data,
+                      gsize         length)
+{
+  guint i;
+
+  for (i = 0; decoders[i]; i++)
+    if (decoders[i]->probe (data, length))
+      return decoders[i];
+
+  return NULL;
+}
+
+static guint
+file_id_hash (gconstpointer key)
+{
+  const GSoundFileId *id = key;
+
+  return (guint) (id->inode ^ (id->inode >> 32) ^ id->device ^
+                  id->size ^ (guint64) id->mtime ^ (guint64) id->mtime_nsec);
+}
+
+static gboolean
+file_id_equal (gconstpointer a,
+               gconstpointer b)
+{
+  return memcmp (a, b, sizeof (GSoundFileId)) == 0;
+}
+
+/* Files rewritten within a second keep their st_mtime, so the nanoseconds
+ * are part of the version too where the system has them */
+static void
+get_file_id (const struct stat *st,
+             GSoundFileId      *id)
+{
+  memset (id, 0, sizeof *id);
+  id->device = st->st_dev;
+  id->inode = st->st_ino;
+  id->size = st->st_size;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM
+  id->mtime = st->st_mtim.tv_sec;
+  id->mtime_nsec = st->st_mtim.tv_nsec;
+#else
+  id->mtime = st->st_mtime;
+#endif
+}
+
+/*
+ * gsound_decoder_info_lookup:
+ * @st: the status of an open file, as given by fstat()
+ * @info: return location for the file's header information
+ *
+ * Looks up the header information last cached for the file, provided it
+ * has not changed since. @st must come from the descriptor the contents
+ * are read from, so that they are the version it describes.
+ *
+ * Returns: %TRUE if @info was found
+ */
+gboolean
+gsound_decoder_info_lookup (const struct stat *st,
+                            GSoundClipInfo    *info)
+{
+  GSoundCachedInfo *cached = NULL;
+  GSoundFileId id;
+
+  get_file_id (st, &id);
+
+  g_mutex_lock (&info_lock);
+  if (infos && (cached = g_hash_table_lookup (infos, &id)))
+    *info = cached->info;
+  g_mutex_unlock (&info_lock);
+
+  return cached != NULL;
+}
+
+/*
+ * gsound_decoder_info_insert:
+ * @st: the status of an open file, as given by fstat()
+ * @info: header information for the file
+ *
+ * Caches @info for the version of the file described by @st.
+ */
+void
+gsound_decoder_info_insert (const struct stat    *st,
+                            const GSoundClipInfo *info)
+{
+  GSoundCachedInfo *cached;
+
+  cached = g_new (GSoundCachedInfo, 1);
+  get_file_id (st, &cached->id);
+  cached->info = *info;
+
+  g_mutex_lock (&info_lock);
+
+  if (!infos)
+    infos = g_hash_table_new_full (file_id_hash, file_id_equal, NULL,
+                                   g_free);
+  else if (g_hash_table_size (infos) >= MAX_CACHED_INFOS)
+    g_hash_table_remove_all (infos);
+
+  g_hash_table_replace (infos, &cached->id, cached);
+
+  g_mutex_unlock (&info_lock);
+}
@@ -0,0 +1,51 @@
+/* gsound-fault-private.h
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GSOUND_FAULT_PRIVATE_H
+#define GSOUND_FAULT_PRIVATE_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * Fault injection between GSound and libcanberra, for stress testing the
+ * error paths against a degraded sound server. Configured with the
+ * GSOUND_FAULT environment variable as a comma-separated list of:
+ *
+ *   latency=MS     delay every backend call by MS milliseconds
+ *   jitter=MS      add up to MS further milliseconds of random delay
+ *   error=NAME     fail backend calls with this error, e.g. "disconnected",
+ *                  "notfound" or "oom" (the GSoundError names)
+ *   error-rate=P   probability of failing a call with @error (default 1)
+ *   lost=P         probability of dropping a completion, so that the sound
+ *                  never finishes unless #GSoundContext:timeout is set
+ *   seed=N         seed for the random choices, for reproducible runs
+ *
+ * For example GSOUND_FAULT=latency=20,jitter=30,error=disconnected,error-rate=0.1
+ */
+
+gboolean gsound_fault_enabled         (void);
+
+int      gsound_fault_call            (void);
+
+gboolean gsound_fault_lose_completion (void);
+
+G_END_DECLS
+
+#endif /* GSOUND_FAULT_PRIVATE_H */
@@ -0,0 +1,218 @@
+/* gsound-fault.c
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gsound-fault-private.h"
+
+#include <canberra.h>
+#include <string.h>
+
+static const struct
+{
+  const char *name;
+  int         code;
+} fault_errors[] = {
+  { "notsupported", CA_ERROR_NOTSUPPORTED },
+  { "invalid", CA_ERROR_INVALID },
+  { "state", CA_ERROR_STATE },
+  { "oom", CA_ERROR_OOM },
+  { "nodriver", CA_ERROR_NODRIVER },
+  { "system", CA_ERROR_SYSTEM },
+  { "corrupt", CA_ERROR_CORRUPT },
+  { "toobig", CA_ERROR_TOOBIG },
+  { "notfound", CA_ERROR_NOTFOUND },
+  { "destroyed", CA_ERROR_DESTROYED },
+  { "canceled", CA_ERROR_CANCELED },
+  { "notavailable", CA_ERROR_NOTAVAILABLE },
+  { "access", CA_ERROR_ACCESS },
+  { "io", CA_ERROR_IO },
+  { "internal", CA_ERROR_INTERNAL },
+  { "disabled", CA_ERROR_DISABLED },
+  { "forked", CA_ERROR_FORKED },
+  { "disconnected", CA_ERROR_DISCONNECTED },
+};
+
+static gboolean fault_enabled;
+static guint fault_latency;
+static guint fault_jitter;
+static int fault_error = CA_SUCCESS;
+static double fault_error_rate = 1.0;
+static double fault_lost;
+static GRand *fault_rand;
+static GMutex fault_lock;
+
+static gboolean
+parse_error (const char *value)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (fault_errors); i++)
+    if (g_ascii_strcasecmp (value, fault_errors[i].name) == 0)
+      {
+        fault_error = fault_errors[i].code;
+        return TRUE;
+      }
+
+  return FALSE;
+}
+
+static gboolean
+parse_probability (const char *value,
+                   double     *p)
+{
+  char *end;
+
+  *p = g_ascii_strtod (value, &end);
+
+  return end != value && *end == '\0' && *p >= 0.0 && *p <= 1.0;
+}
+
+static gboolean
+parse_ms (const char *value,
+          guint      *ms)
+{
+  guint64 v;
+
+  if (!g_ascii_string_to_unsigned (value, 10, 0, G_MAXUINT, &v, NULL))
+    return FALSE;
+
+  *ms = (guint) v;
+  return TRUE;
+}
+
+static void
+parse_spec (const char *spec)
+{
+  char **options = g_strsplit (spec, ",", -1);
+  guint64 seed = 0;
+  gboolean have_seed = FALSE;
+  guint i;
+
+  for (i = 0; options[i]; i++)
+    {
+      char *option = g_strstrip (options[i]);
+      char *value = strchr (option, '=');
+      gboolean ok = FALSE;
+
+      if (*option == '\0')
+        continue;
+
+      if (value)
+        {
+          *value++ = '\0';
+
+          if (strcmp (option, "latency") == 0)
+            ok = parse_ms (value, &fault_latency);
+          else if (strcmp (option, "jitter") == 0)
+            ok = parse_ms (value, &fault_jitter);
+          else if (strcmp (option, "error") == 0)
+            ok = parse_error (value);
+          else if (strcmp (option, "error-rate") == 0)
+            ok = parse_probability (value, &fault_error_rate);
+          else if (strcmp (option, "lost") == 0)
+            ok = parse_probability (value, &fault_lost);
+          else if (strcmp (option, "seed") == 0)
+            ok = have_seed = g_ascii_string_to_unsigned (value, 10, 0,
+                                                         G_MAXUINT32, &seed,
+                                                         NULL);
+        }
+
+      if (!ok)
+        g_warning ("Ignoring invalid GSOUND_FAULT option “%s”", option);
+    }
+
+  g_strfreev (options);
+
+  fault_rand = have_seed ? g_rand_new_with_seed ((guint32) seed) : g_rand_new ();
+}
+
+gboolean
+gsound_fault_enabled (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      const char *spec = g_getenv ("GSOUND_FAULT");
+
+      if (spec && *spec)
+        {
+          parse_spec (spec);
+          fault_enabled = TRUE;
+        }
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return fault_enabled;
+}
+
+static double
+fault_random (void)
+{
+  double r;
+
+  g_mutex_lock (&fault_lock);
+  r = g_rand_double (fault_rand);
+  g_mutex_unlock (&fault_lock);
+
+  return r;
+}
+
+/*
+ * gsound_fault_call:
+ *
+ * To be called before each libcanberra call which talks to the sound
+ * server. Blocks for the configured latency, then decides whether the
+ * call should fail.
+ *
+ * Returns: the error the call should fail with, or %CA_SUCCESS if it
+ *   should go ahead
+ */
+int
+gsound_fault_call (void)
+{
+  guint delay;
+
+  if (G_LIKELY (!gsound_fault_enabled ()))
+    return CA_SUCCESS;
+
+  delay = fault_latency;
+  if (fault_jitter > 0)
+    delay += (guint) (fault_random () * fault_jitter);
+  if (delay > 0)
+    g_usleep ((gulong) delay * 1000);
+
+  if (fault_error != CA_SUCCESS && fault_random () < fault_error_rate)
+    return fault_error;
+
+  return CA_SUCCESS;
+}
+
+/*
+ * gsound_fault_lose_completion:
+ *
+ * Returns: %TRUE if a completion reported by the backend should be dropped
+ */
+gboolean
+gsound_fault_lose_completion (void)
+{
+  if (G_LIKELY (!gsound_fault_enabled ()))
+    return FALSE;
+
+  return fault_lost > 0.0 && fault_random () < fault_lost;
+}
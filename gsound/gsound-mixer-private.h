@@ -0,0 +1,73 @@
+/* gsound-mixer-private.h
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GSOUND_MIXER_PRIVATE_H
+#define GSOUND_MIXER_PRIVATE_H
+
+#include "gsound-clip-private.h"
+
+G_BEGIN_DECLS
+
+/*
+ * GSoundMixer:
+ *
+ * An offline mixer which sums clips into a growing float buffer at a fixed
+ * output rate and channel count. Used by gsound_context_render().
+ */
+typedef struct _GSoundMixer GSoundMixer;
+
+/*
+ * GSoundVoice:
+ * @offset: start position in output frames
+ * @gain: linear gain
+ * @pan: stereo position, from -1.0 (left) through 0.0 (centre) to 1.0
+ *   (right)
+ * @stop: number of frames after @offset at which the voice is cancelled,
+ *   or %G_MAXSIZE to play the whole clip
+ * @fade_out: number of frames over which a cancelled voice fades to
+ *   silence, starting at @stop
+ *
+ * Placement and parameters of a clip added to a #GSoundMixer.
+ */
+typedef struct
+{
+  gsize offset;
+  float gain;
+  float pan;
+  gsize stop;
+  gsize fade_out;
+} GSoundVoice;
+
+#define GSOUND_VOICE_INIT { 0, 1.0f, 0.0f, G_MAXSIZE, 0 }
+
+GSoundMixer *gsound_mixer_new          (guint        rate,
+                                        guint        channels);
+
+void         gsound_mixer_free         (GSoundMixer *mixer);
+
+void         gsound_mixer_add          (GSoundMixer       *mixer,
+                                        GSoundClip        *clip,
+                                        const GSoundVoice *voice);
+
+gsize        gsound_mixer_get_n_frames (GSoundMixer *mixer);
+
+GBytes      *gsound_mixer_to_s16       (GSoundMixer *mixer);
+
+G_END_DECLS
+
+#endif /* GSOUND_MIXER_PRIVATE_H */
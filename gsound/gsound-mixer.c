@@ -0,0 +1,273 @@
+/* gsound-mixer.c
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gsound-mixer-private.h"
+
+#include <math.h>
+
+#define MAX_CHANNELS 8
+
+struct _GSoundMixer
+{
+  guint  rate;
+  guint  channels;
+
+  float *buffer;
+  gsize  n_frames;
+  gsize  n_allocated;
+};
+
+GSoundMixer *
+gsound_mixer_new (guint rate,
+                  guint channels)
+{
+  GSoundMixer *mixer;
+
+  g_return_val_if_fail (rate > 0, NULL);
+  g_return_val_if_fail (channels > 0 && channels <= MAX_CHANNELS, NULL);
+
+  mixer = g_slice_new0 (GSoundMixer);
+  mixer->rate = rate;
+  mixer->channels = channels;
+
+  return mixer;
+}
+
+void
+gsound_mixer_free (GSoundMixer *mixer)
+{
+  g_free (mixer->buffer);
+  g_slice_free (GSoundMixer, mixer);
+}
+
+static void
+ensure_frames (GSoundMixer *mixer,
+               gsize        n_frames)
+{
+  gsize n_allocated = mixer->n_allocated;
+
+  if (n_frames > mixer->n_frames)
+    mixer->n_frames = n_frames;
+
+  if (n_frames <= n_allocated)
+    return;
+
+  n_allocated = MAX (n_allocated * 2, n_frames);
+  mixer->buffer = g_renew (float, mixer->buffer, n_allocated * mixer->channels);
+  memset (mixer->buffer + mixer->n_allocated * mixer->channels, 0,
+          (n_allocated - mixer->n_allocated) * mixer->channels * sizeof (float));
+  mixer->n_allocated = n_allocated;
+}
+
+/* Side of each output channel for panning, following the WAV channel
+ * order: -1 for left, 1 for right and 0 for centre and LFE channels */
+static const gint8 channel_sides[MAX_CHANNELS + 1][MAX_CHANNELS] = {
+  [2] = { -1, 1 },
+  [3] = { -1, 1, 0 },
+  [4] = { -1, 1, -1, 1 },
+  [5] = { -1, 1, 0, -1, 1 },
+  [6] = { -1, 1, 0, 0, -1, 1 },
+  [7] = { -1, 1, 0, 0, 0, -1, 1 },
+  [8] = { -1, 1, 0, 0, -1, 1, -1, 1 },
+};
+
+/* Balance law: the channels on the side towards @pan keep full gain and
+ * those on the far side fade out, by 3 dB at half way. Centred sounds are
+ * left untouched, so panning never makes a sound louder. */
+static void
+compute_gains (GSoundMixer       *mixer,
+               const GSoundVoice *voice,
+               float             *gains)
+{
+  float pan = CLAMP (voice->pan, -1.0f, 1.0f);
+  float left = sqrtf (MIN (1.0f - pan, 1.0f));
+  float right = sqrtf (MIN (1.0f + pan, 1.0f));
+  guint c;
+
+  for (c = 0; c < mixer->channels; c++)
+    {
+      gint8 side = channel_sides[mixer->channels][c];
+
+      gains[c] = voice->gain * (side < 0 ? left : side > 0 ? right : 1.0f);
+    }
+}
+
+/* The kernels below mix @n_frames frames at the same rate with constant
+ * per-channel @gains. They are written as plain loops without dependencies
+ * between frames, so that the compiler vectorises them. */
+
+static void
+mix_mono_to_stereo (float       *dst,
+                    const float *src,
+                    gsize        n_frames,
+                    const float *gains)
+{
+  float left = gains[0], right = gains[1];
+  gsize i;
+
+  for (i = 0; i < n_frames; i++)
+    {
+      dst[2 * i] += left * src[i];
+      dst[2 * i + 1] += right * src[i];
+    }
+}
+
+static void
+mix_stereo (float       *dst,
+            const float *src,
+            gsize        n_frames,
+            const float *gains)
+{
+  float left = gains[0], right = gains[1];
+  gsize i;
+
+  for (i = 0; i < n_frames; i++)
+    {
+      dst[2 * i] += left * src[2 * i];
+      dst[2 * i + 1] += right * src[2 * i + 1];
+    }
+}
+
+static void
+mix_same_channels (float       *dst,
+                   const float *src,
+                   gsize        n_frames,
+                   guint        channels,
+                   const float *gains)
+{
+  guint c;
+  gsize i;
+
+  /* One channel at a time keeps the gain constant across the loop */
+  for (c = 0; c < channels; c++)
+    for (i = 0; i < n_frames; i++)
+      dst[i * channels + c] += gains[c] * src[i * channels + c];
+}
+
+/*
+ * gsound_mixer_add:
+ * @mixer: a #GSoundMixer
+ * @clip: the clip to mix in
+ * @voice: where and how to play @clip
+ *
+ * Sums @clip into the output as described by @voice, converting sample
+ * rate and channel layout as necessary.
+ */
+void
+gsound_mixer_add (GSoundMixer       *mixer,
+                  GSoundClip        *clip,
+                  const GSoundVoice *voice)
+{
+  double step = (double) clip->rate / mixer->rate;
+  float gains[MAX_CHANNELS];
+  gsize n_frames, i;
+
+  if (clip->n_frames == 0)
+    return;
+
+  n_frames = (gsize) ceil ((clip->n_frames - 1) / step) + 1;
+  if (voice->stop < n_frames)
+    n_frames = MIN (n_frames, voice->stop + voice->fade_out);
+
+  ensure_frames (mixer, voice->offset + n_frames);
+  compute_gains (mixer, voice, gains);
+
+  /* Sounds at the output rate which play to the end take the fast path */
+  if (clip->rate == mixer->rate && n_frames <= voice->stop)
+    {
+      float *dst = mixer->buffer + voice->offset * mixer->channels;
+
+      if (clip->channels == 1 && mixer->channels == 2)
+        {
+          mix_mono_to_stereo (dst, clip->samples, n_frames, gains);
+          return;
+        }
+      else if (clip->channels == 2 && mixer->channels == 2)
+        {
+          mix_stereo (dst, clip->samples, n_frames, gains);
+          return;
+        }
+      else if (clip->channels == mixer->channels)
+        {
+          mix_same_channels (dst, clip->samples, n_frames,
+                             mixer->channels, gains);
+          return;
+        }
+    }
+
+  for (i = 0; i < n_frames; i++)
+    {
+      float *dst = mixer->buffer + (voice->offset + i) * mixer->channels;
+      float frame[MAX_CHANNELS];
+      float fade = 1.0f;
+      guint c;
+
+      if (i >= voice->stop)
+        fade = 1.0f - (float) (i - voice->stop) / voice->fade_out;
+
+      if (clip->rate == mixer->rate)
+        memcpy (frame, clip->samples + i * clip->channels,
+                clip->channels * sizeof (float));
+      else
+        gsound_clip_read_frame (clip, i, step, frame);
+
+      if (mixer->channels == 1 && clip->channels > 1)
+        {
+          float sum = 0.0f;
+
+          for (c = 0; c < clip->channels; c++)
+            sum += frame[c];
+          dst[0] += fade * gains[0] * sum / clip->channels;
+        }
+      else
+        {
+          for (c = 0; c < mixer->channels; c++)
+            dst[c] += fade * gains[c] * frame[c % clip->channels];
+        }
+    }
+}
+
+gsize
+gsound_mixer_get_n_frames (GSoundMixer *mixer)
+{
+  return mixer->n_frames;
+}
+
+/*
+ * gsound_mixer_to_s16:
+ * @mixer: a #GSoundMixer
+ *
+ * Returns: (transfer full): the mixed output as interleaved signed 16-bit
+ *   little-endian samples, clipped to the representable range
+ */
+GBytes *
+gsound_mixer_to_s16 (GSoundMixer *mixer)
+{
+  gsize n_samples = mixer->n_frames * mixer->channels;
+  gint16 *out = g_new (gint16, n_samples);
+  gsize i;
+
+  for (i = 0; i < n_samples; i++)
+    {
+      long s = lrintf (mixer->buffer[i] * 32767.0f);
+
+      out[i] = GINT16_TO_LE ((gint16) CLAMP (s, G_MININT16, G_MAXINT16));
+    }
+
+  return g_bytes_new_take (out, n_samples * sizeof (gint16));
+}
@@ -0,0 +1,46 @@
+/* gsound-pool-private.h
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GSOUND_POOL_PRIVATE_H
+#define GSOUND_POOL_PRIVATE_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * GSoundPoolFunc:
+ * @item: the item to process
+ * @user_data: the data passed to gsound_pool_run()
+ *
+ * Processes one item of a gsound_pool_run() call. Called from any thread,
+ * possibly concurrently for other items.
+ */
+typedef void (*GSoundPoolFunc) (gpointer item,
+                                gpointer user_data);
+
+guint gsound_pool_get_n_threads (void);
+
+void  gsound_pool_run           (GSoundPoolFunc  func,
+                                 gpointer       *items,
+                                 guint           n_items,
+                                 gpointer        user_data);
+
+G_END_DECLS
+
+#endif /* GSOUND_POOL_PRIVATE_H */
@@ -0,0 +1,261 @@
+/* gsound-pool.c
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* A process-wide pool of worker threads for CPU-bound work such as
+ * decoding clips. Each worker has its own deque of tasks: it takes work
+ * from the head of its own deque and, once that is empty, steals from the
+ * tail of the others, so that a few slow items do not leave the remaining
+ * threads idle. The thread calling gsound_pool_run() joins in until its
+ * items are done.
+ *
+ * The pool uses one thread per processor, counting the caller, unless the
+ * `GSOUND_THREADS` environment variable says otherwise; setting it to 1
+ * runs everything on the calling thread, which gives the baseline when
+ * measuring the speedup. */
+
+#include "gsound-pool-private.h"
+
+#define MAX_THREADS 64
+
+typedef struct
+{
+  GSoundPoolFunc func;
+  gpointer       user_data;
+
+  /* Items not yet finished, under @lock */
+  gint           pending;
+  GMutex         lock;
+  GCond          cond;
+} GSoundPoolJob;
+
+typedef struct
+{
+  GSoundPoolJob *job;
+  gpointer       item;
+} GSoundPoolTask;
+
+typedef struct
+{
+  GMutex lock;
+  GQueue tasks;
+} GSoundPoolDeque;
+
+static guint n_threads;
+static guint n_workers;
+static GSoundPoolDeque *deques;
+
+/* Number of tasks in all deques, under @pool_lock, which idle workers wait
+ * on @pool_cond to become non-zero */
+static GMutex pool_lock;
+static GCond pool_cond;
+static guint n_queued;
+
+static GSoundPoolTask *
+deque_take (GSoundPoolDeque *deque,
+            gboolean         steal)
+{
+  GSoundPoolTask *task;
+
+  g_mutex_lock (&deque->lock);
+  task = steal ? g_queue_pop_tail (&deque->tasks)
+               : g_queue_pop_head (&deque->tasks);
+  g_mutex_unlock (&deque->lock);
+
+  if (task)
+    {
+      g_mutex_lock (&pool_lock);
+      n_queued--;
+      g_mutex_unlock (&pool_lock);
+    }
+
+  return task;
+}
+
+/* Takes a task from deque @own, or failing that steals one from the
+ * others. @own may be n_workers for a caller, which has no deque. */
+static GSoundPoolTask *
+pool_take (guint own)
+{
+  GSoundPoolTask *task = NULL;
+  guint i;
+
+  if (own < n_workers)
+    task = deque_take (&deques[own], FALSE);
+
+  for (i = 1; !task && i <= n_workers; i++)
+    task = deque_take (&deques[(own + i) % n_workers], TRUE);
+
+  return task;
+}
+
+static void
+task_run (GSoundPoolTask *task)
+{
+  GSoundPoolJob *job = task->job;
+
+  job->func (task->item, job->user_data);
+
+  /* Under the lock, so that the caller cannot see the job finish and free
+   * it while it is still being signalled */
+  g_mutex_lock (&job->lock);
+  if (--job->pending == 0)
+    g_cond_signal (&job->cond);
+  g_mutex_unlock (&job->lock);
+}
+
+static gpointer
+worker_func (gpointer data)
+{
+  guint own = GPOINTER_TO_UINT (data);
+
+  while (TRUE)
+    {
+      GSoundPoolTask *task = pool_take (own);
+
+      if (task)
+        {
+          task_run (task);
+          continue;
+        }
+
+      g_mutex_lock (&pool_lock);
+      while (n_queued == 0)
+        g_cond_wait (&pool_cond, &pool_lock);
+      g_mutex_unlock (&pool_lock);
+    }
+
+  return NULL;
+}
+
+static void
+pool_init (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      const char *env = g_getenv ("GSOUND_THREADS");
+      guint64 threads = 0;
+      guint i;
+
+      if (env && !g_ascii_string_to_unsigned (env, 10, 1, MAX_THREADS,
+                                              &threads, NULL))
+        g_warning ("Ignoring invalid GSOUND_THREADS value “%s”", env);
+
+      n_threads = threads ? (guint) threads
+                          : CLAMP (g_get_num_processors (), 1, MAX_THREADS);
+      n_workers = n_threads - 1;
+
+      deques = g_new0 (GSoundPoolDeque, MAX (n_workers, 1));
+      for (i = 0; i < n_workers; i++)
+        {
+          g_mutex_init (&deques[i].lock);
+          g_queue_init (&deques[i].tasks);
+          g_thread_unref (g_thread_new ("gsound-pool", worker_func,
+                                        GUINT_TO_POINTER (i)));
+        }
+
+      g_once_init_leave (&initialized, 1);
+    }
+}
+
+/*
+ * gsound_pool_get_n_threads:
+ *
+ * Returns: the number of threads which gsound_pool_run() spreads work
+ *   over, including the calling thread
+ */
+guint
+gsound_pool_get_n_threads (void)
+{
+  pool_init ();
+
+  return n_threads;
+}
+
+/*
+ * gsound_pool_run:
+ * @func: the function to call for each item
+ * @items: (array length=n_items): the items
+ * @n_items: the number of items
+ * @user_data: data to pass to @func
+ *
+ * Calls @func on every item of @items in parallel on the shared pool, and
+ * waits for all of them to finish. Any number of threads may call this at
+ * the same time.
+ */
+void
+gsound_pool_run (GSoundPoolFunc  func,
+                 gpointer       *items,
+                 guint           n_items,
+                 gpointer        user_data)
+{
+  GSoundPoolJob job = { func, user_data, (gint) n_items };
+  GSoundPoolTask *tasks;
+  GSoundPoolTask *task;
+  guint i;
+
+  pool_init ();
+
+  if (n_workers == 0 || n_items <= 1)
+    {
+      for (i = 0; i < n_items; i++)
+        func (items[i], user_data);
+      return;
+    }
+
+  g_mutex_init (&job.lock);
+  g_cond_init (&job.cond);
+
+  tasks = g_new (GSoundPoolTask, n_items);
+
+  g_mutex_lock (&pool_lock);
+  n_queued += n_items;
+  g_mutex_unlock (&pool_lock);
+
+  /* Deal the items out round robin. Stealing evens out the rest. */
+  for (i = 0; i < n_items; i++)
+    {
+      GSoundPoolDeque *deque = &deques[i % n_workers];
+
+      tasks[i].job = &job;
+      tasks[i].item = items[i];
+
+      g_mutex_lock (&deque->lock);
+      g_queue_push_tail (&deque->tasks, &tasks[i]);
+      g_mutex_unlock (&deque->lock);
+    }
+
+  g_mutex_lock (&pool_lock);
+  g_cond_broadcast (&pool_cond);
+  g_mutex_unlock (&pool_lock);
+
+  /* Help out rather than sit idle. This may run tasks of other callers,
+   * which finish all the same. */
+  while ((task = pool_take (n_workers)))
+    task_run (task);
+
+  g_mutex_lock (&job.lock);
+  while (job.pending > 0)
+    g_cond_wait (&job.cond, &job.lock);
+  g_mutex_unlock (&job.lock);
+
+  g_mutex_clear (&job.lock);
+  g_cond_clear (&job.cond);
+  g_free (tasks);
+}
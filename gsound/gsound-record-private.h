@@ -0,0 +1,81 @@
+/* gsound-record-private.h
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GSOUND_RECORD_PRIVATE_H
+#define GSOUND_RECORD_PRIVATE_H
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/*
+ * A compact binary log of the calls made on GSound contexts, written to
+ * the file named by the GSOUND_RECORD environment variable and replayed
+ * with gsound_context_replay().
+ *
+ * The log starts with the 8-byte magic "GSNDREC1". Each entry is an
+ * operation byte, the time since the previous entry in microseconds, then
+ * the operation's fields. Integers are unsigned LEB128. Strings are
+ * interned: a reference of 0 is followed by the length and bytes of a new
+ * string, any other reference n names the n-th string seen so far.
+ *
+ *   PLAY            id, n_attrs, n_attrs × (key, value)
+ *   CACHE           n_attrs, n_attrs × (key, value)
+ *   CANCEL          id
+ *   CANCEL_MATCHING n_attrs, n_attrs × (key, value)
+ */
+typedef enum
+{
+  GSOUND_RECORD_PLAY = 1,
+  GSOUND_RECORD_CACHE,
+  GSOUND_RECORD_CANCEL,
+  GSOUND_RECORD_CANCEL_MATCHING
+} GSoundRecordOp;
+
+typedef struct
+{
+  GSoundRecordOp      op;
+  gint64              time;
+  guint32             id;
+  guint               n_attrs;
+  const char * const *attrs;
+} GSoundRecordEntry;
+
+typedef struct _GSoundRecordReader GSoundRecordReader;
+
+gboolean            gsound_record_enabled      (void);
+
+void                gsound_record_attrs        (GSoundRecordOp       op,
+                                                guint32              id,
+                                                const char * const  *attrs,
+                                                guint                n_attrs);
+
+void                gsound_record_cancel       (guint32              id);
+
+GSoundRecordReader *gsound_record_reader_new   (GBytes              *bytes,
+                                                GError             **error);
+
+gboolean            gsound_record_reader_next  (GSoundRecordReader  *reader,
+                                                GSoundRecordEntry   *entry,
+                                                GError             **error);
+
+void                gsound_record_reader_free  (GSoundRecordReader  *reader);
+
+G_END_DECLS
+
+#endif /* GSOUND_RECORD_PRIVATE_H */
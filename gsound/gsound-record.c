@@ -0,0 +1,343 @@
+/* gsound-record.c
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gsound-record-private.h"
+#include "gsound-context.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define RECORD_MAGIC "GSNDREC1"
+#define RECORD_MAGIC_LEN 8
+
+static FILE *record_file;
+static GMutex record_lock;
+static GHashTable *record_strings;
+static gint64 record_last;
+
+gboolean
+gsound_record_enabled (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      const char *path = g_getenv ("GSOUND_RECORD");
+
+      if (path && *path)
+        {
+          record_file = fopen (path, "wb");
+          if (record_file)
+            {
+              fwrite (RECORD_MAGIC, 1, RECORD_MAGIC_LEN, record_file);
+              record_strings = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                      g_free, NULL);
+              record_last = g_get_monotonic_time ();
+            }
+          else
+            g_warning ("Could not open GSOUND_RECORD file “%s”", path);
+        }
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return record_file != NULL;
+}
+
+static void
+append_uint (GByteArray *buf,
+             guint64     value)
+{
+  do
+    {
+      guint8 byte = value & 0x7f;
+
+      value >>= 7;
+      if (value)
+        byte |= 0x80;
+      g_byte_array_append (buf, &byte, 1);
+    }
+  while (value);
+}
+
+/* Called with the lock held */
+static void
+append_string (GByteArray *buf,
+               const char *str)
+{
+  gpointer ref;
+
+  if (g_hash_table_lookup_extended (record_strings, str, NULL, &ref))
+    {
+      append_uint (buf, GPOINTER_TO_UINT (ref));
+      return;
+    }
+
+  g_hash_table_insert (record_strings, g_strdup (str),
+                       GUINT_TO_POINTER (g_hash_table_size (record_strings) + 1));
+
+  append_uint (buf, 0);
+  append_uint (buf, strlen (str));
+  g_byte_array_append (buf, (const guint8 *) str, strlen (str));
+}
+
+/* Called with the lock held */
+static void
+append_header (GByteArray     *buf,
+               GSoundRecordOp  op)
+{
+  guint8 byte = op;
+  gint64 now = g_get_monotonic_time ();
+
+  g_byte_array_append (buf, &byte, 1);
+  append_uint (buf, MAX (now - record_last, 0));
+  record_last = now;
+}
+
+static void
+write_entry (GByteArray *buf)
+{
+  fwrite (buf->data, 1, buf->len, record_file);
+  fflush (record_file);
+  g_byte_array_unref (buf);
+}
+
+/*
+ * gsound_record_attrs:
+ * @op: a #GSoundRecordOp other than %GSOUND_RECORD_CANCEL
+ * @id: the play id, for %GSOUND_RECORD_PLAY
+ * @attrs: key/value pairs
+ * @n_attrs: the number of pairs in @attrs
+ *
+ * Appends a call taking attributes to the log.
+ */
+void
+gsound_record_attrs (GSoundRecordOp      op,
+                     guint32             id,
+                     const char * const *attrs,
+                     guint               n_attrs)
+{
+  GByteArray *buf;
+  guint i;
+
+  if (G_LIKELY (!gsound_record_enabled ()))
+    return;
+
+  buf = g_byte_array_sized_new (128);
+
+  g_mutex_lock (&record_lock);
+
+  append_header (buf, op);
+  if (op == GSOUND_RECORD_PLAY)
+    append_uint (buf, id);
+  append_uint (buf, n_attrs);
+  for (i = 0; i < 2 * n_attrs; i++)
+    append_string (buf, attrs[i]);
+
+  write_entry (buf);
+
+  g_mutex_unlock (&record_lock);
+}
+
+/*
+ * gsound_record_cancel:
+ * @id: the play id
+ *
+ * Appends the cancellation of a play through its #GCancellable to the log.
+ */
+void
+gsound_record_cancel (guint32 id)
+{
+  GByteArray *buf;
+
+  if (G_LIKELY (!gsound_record_enabled ()))
+    return;
+
+  buf = g_byte_array_sized_new (16);
+
+  g_mutex_lock (&record_lock);
+
+  append_header (buf, GSOUND_RECORD_CANCEL);
+  append_uint (buf, id);
+  write_entry (buf);
+
+  g_mutex_unlock (&record_lock);
+}
+
+struct _GSoundRecordReader
+{
+  GBytes       *bytes;
+  const guint8 *data;
+  gsize         length;
+  gsize         pos;
+  gint64        time;
+  GPtrArray    *strings;
+  GPtrArray    *attrs;
+};
+
+GSoundRecordReader *
+gsound_record_reader_new (GBytes  *bytes,
+                          GError **error)
+{
+  GSoundRecordReader *reader;
+  gsize length;
+  const guint8 *data = g_bytes_get_data (bytes, &length);
+
+  if (length < RECORD_MAGIC_LEN ||
+      memcmp (data, RECORD_MAGIC, RECORD_MAGIC_LEN) != 0)
+    {
+      g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_CORRUPT,
+                           "Not a GSound recording");
+      return NULL;
+    }
+
+  reader = g_slice_new0 (GSoundRecordReader);
+  reader->bytes = g_bytes_ref (bytes);
+  reader->data = data;
+  reader->length = length;
+  reader->pos = RECORD_MAGIC_LEN;
+  reader->strings = g_ptr_array_new_with_free_func (g_free);
+  reader->attrs = g_ptr_array_new ();
+
+  return reader;
+}
+
+void
+gsound_record_reader_free (GSoundRecordReader *reader)
+{
+  g_ptr_array_unref (reader->attrs);
+  g_ptr_array_unref (reader->strings);
+  g_bytes_unref (reader->bytes);
+  g_slice_free (GSoundRecordReader, reader);
+}
+
+static gboolean
+read_uint (GSoundRecordReader *reader,
+           guint64            *value)
+{
+  guint shift = 0;
+
+  *value = 0;
+  while (reader->pos < reader->length && shift < 64)
+    {
+      guint8 byte = reader->data[reader->pos++];
+
+      *value |= (guint64) (byte & 0x7f) << shift;
+      if (!(byte & 0x80))
+        return TRUE;
+      shift += 7;
+    }
+
+  return FALSE;
+}
+
+static const char *
+read_string (GSoundRecordReader *reader)
+{
+  guint64 ref, len;
+  char *str;
+
+  if (!read_uint (reader, &ref))
+    return NULL;
+
+  if (ref > 0)
+    return ref <= reader->strings->len ? reader->strings->pdata[ref - 1] : NULL;
+
+  if (!read_uint (reader, &len) || len > reader->length - reader->pos)
+    return NULL;
+
+  str = g_strndup ((const char *) reader->data + reader->pos, len);
+  reader->pos += len;
+  g_ptr_array_add (reader->strings, str);
+
+  return str;
+}
+
+/*
+ * gsound_record_reader_next:
+ * @reader: a #GSoundRecordReader
+ * @entry: (out): location for the next entry
+ * @error: Return location for error
+ *
+ * Reads the next entry of the log. The strings in @entry belong to
+ * @reader, and the attribute array is only valid until the next call.
+ * @entry->time is the time of the entry relative to the start of the log.
+ *
+ * Returns: %TRUE if an entry was read, %FALSE at the end of the log or
+ *   if it is corrupt, in which case @error is set
+ */
+gboolean
+gsound_record_reader_next (GSoundRecordReader *reader,
+                           GSoundRecordEntry  *entry,
+                           GError            **error)
+{
+  guint64 delta, value, n_attrs = 0;
+  guint8 op;
+  guint i;
+
+  if (reader->pos >= reader->length)
+    return FALSE;
+
+  op = reader->data[reader->pos++];
+  if (op < GSOUND_RECORD_PLAY || op > GSOUND_RECORD_CANCEL_MATCHING ||
+      !read_uint (reader, &delta))
+    goto corrupt;
+
+  reader->time += delta;
+
+  entry->op = op;
+  entry->time = reader->time;
+  entry->id = 0;
+
+  if (op == GSOUND_RECORD_PLAY || op == GSOUND_RECORD_CANCEL)
+    {
+      if (!read_uint (reader, &value) || value > G_MAXUINT32)
+        goto corrupt;
+      entry->id = value;
+    }
+
+  g_ptr_array_set_size (reader->attrs, 0);
+
+  if (op != GSOUND_RECORD_CANCEL)
+    {
+      /* Each attribute takes at least two bytes */
+      if (!read_uint (reader, &n_attrs) ||
+          n_attrs > (reader->length - reader->pos) / 2)
+        goto corrupt;
+
+      for (i = 0; i < 2 * n_attrs; i++)
+        {
+          const char *str = read_string (reader);
+
+          if (!str)
+            goto corrupt;
+          g_ptr_array_add (reader->attrs, (gpointer) str);
+        }
+    }
+
+  entry->n_attrs = n_attrs;
+  entry->attrs = (const char * const *) reader->attrs->pdata;
+
+  return TRUE;
+
+corrupt:
+  g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_CORRUPT,
+               "Corrupt GSound recording at offset %" G_GSIZE_FORMAT,
+               reader->pos);
+  return FALSE;
+}
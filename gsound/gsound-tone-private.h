@@ -0,0 +1,85 @@
+/* gsound-tone-private.h
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GSOUND_TONE_PRIVATE_H
+#define GSOUND_TONE_PRIVATE_H
+
+#include "gsound-clip-private.h"
+
+G_BEGIN_DECLS
+
+/* Rate at which tones are generated when no output rate is known */
+#define GSOUND_TONE_RATE 48000
+
+typedef enum
+{
+  GSOUND_WAVEFORM_SINE,
+  GSOUND_WAVEFORM_SQUARE,
+  GSOUND_WAVEFORM_TRIANGLE,
+  GSOUND_WAVEFORM_SAWTOOTH,
+} GSoundWaveform;
+
+/*
+ * GSoundTone:
+ * @waveform: the waveform
+ * @frequency: frequency in Hz at the start of the tone
+ * @frequency_end: frequency in Hz at the end of the tone
+ * @duration: length in milliseconds
+ * @attack: fade in time in milliseconds
+ * @release: fade out time in milliseconds
+ *
+ * A synthesized sound, as described by the "gsound.tone" attributes.
+ */
+typedef struct
+{
+  GSoundWaveform waveform;
+  double         frequency;
+  double         frequency_end;
+  guint          duration;
+  guint          attack;
+  guint          release;
+} GSoundTone;
+
+gboolean    gsound_tone_parse     (GSoundTone        *tone,
+                                   const char        *frequency,
+                                   const char        *frequency_end,
+                                   const char        *waveform,
+                                   const char        *duration,
+                                   const char        *attack,
+                                   const char        *release,
+                                   GError           **error);
+
+GSoundClip *gsound_tone_render    (const GSoundTone  *tone,
+                                   guint              rate);
+
+char       *gsound_tone_to_string (const GSoundTone  *tone);
+
+typedef struct _GSoundToneFile GSoundToneFile;
+
+GSoundToneFile *gsound_tone_get_file      (const GSoundTone  *tone,
+                                           GError           **error);
+
+GSoundToneFile *gsound_tone_file_ref      (GSoundToneFile    *file);
+
+void            gsound_tone_file_unref    (GSoundToneFile    *file);
+
+const char     *gsound_tone_file_get_path (GSoundToneFile    *file);
+
+G_END_DECLS
+
+#endif /* GSOUND_TONE_PRIVATE_H */
@@ -0,0 +1,628 @@
+/* gsound-tone.c
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_MEMFD_CREATE
+#define _GNU_SOURCE
+#endif
+
+#include "gsound-tone-private.h"
+#include "gsound-context.h"
+#include "gsound-mixer-private.h"
+
+#include <glib/gstdio.h>
+
+#include <errno.h>
+#include <math.h>
+#include <unistd.h>
+
+#ifdef HAVE_MEMFD_CREATE
+#include <sys/mman.h>
+#endif
+
+#define MIN_FREQUENCY 20.0
+#define MAX_FREQUENCY 20000.0
+#define MAX_DURATION  10000
+
+/* Tones are generated at half of full scale, leaving headroom for mixing */
+#define TONE_GAIN 0.5f
+
+/* Frames generated at a time, small enough for the scratch buffers to stay
+ * in cache and large enough for the loops below to vectorise well */
+#define BLOCK_SIZE 256
+
+static const char * const waveform_names[] = {
+  [GSOUND_WAVEFORM_SINE] = "sine",
+  [GSOUND_WAVEFORM_SQUARE] = "square",
+  [GSOUND_WAVEFORM_TRIANGLE] = "triangle",
+  [GSOUND_WAVEFORM_SAWTOOTH] = "sawtooth",
+};
+
+static GMutex tone_lock;
+static GHashTable *tone_files;
+
+static gboolean
+parse_frequency (const char  *value,
+                 const char  *key,
+                 double      *frequency,
+                 GError     **error)
+{
+  char *end;
+
+  *frequency = g_ascii_strtod (value, &end);
+  if (end == value || *end != '\0' ||
+      !(*frequency >= MIN_FREQUENCY && *frequency <= MAX_FREQUENCY))
+    {
+      g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_INVALID,
+                   "Invalid value “%s” for attribute “%s”, expected a "
+                   "frequency between %g and %g Hz",
+                   value, key, MIN_FREQUENCY, MAX_FREQUENCY);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+parse_ms (const char  *value,
+          const char  *key,
+          guint64      max,
+          guint       *ms,
+          GError     **error)
+{
+  guint64 v;
+
+  if (!value)
+    return TRUE;
+
+  if (!g_ascii_string_to_unsigned (value, 10, 0, max, &v, NULL))
+    {
+      g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_INVALID,
+                   "Invalid value “%s” for attribute “%s”, expected a "
+                   "duration of at most %" G_GUINT64_FORMAT " ms",
+                   value, key, max);
+      return FALSE;
+    }
+
+  *ms = (guint) v;
+  return TRUE;
+}
+
+/*
+ * gsound_tone_parse:
+ * @tone: the tone to fill in
+ * @frequency: value of #GSOUND_ATTR_GSOUND_TONE_FREQUENCY
+ * @frequency_end: (nullable): value of #GSOUND_ATTR_GSOUND_TONE_FREQUENCY_END
+ * @waveform: (nullable): value of #GSOUND_ATTR_GSOUND_TONE_WAVEFORM
+ * @duration: (nullable): value of #GSOUND_ATTR_GSOUND_TONE_DURATION
+ * @attack: (nullable): value of #GSOUND_ATTR_GSOUND_TONE_ATTACK
+ * @release: (nullable): value of #GSOUND_ATTR_GSOUND_TONE_RELEASE
+ * @error: Return location for error
+ *
+ * Fills in @tone from attribute values, applying defaults for those which
+ * are %NULL.
+ *
+ * Returns: %TRUE on success, or %FALSE (populating @error)
+ */
+gboolean
+gsound_tone_parse (GSoundTone  *tone,
+                   const char  *frequency,
+                   const char  *frequency_end,
+                   const char  *waveform,
+                   const char  *duration,
+                   const char  *attack,
+                   const char  *release,
+                   GError     **error)
+{
+  guint i;
+
+  tone->waveform = GSOUND_WAVEFORM_SINE;
+  tone->duration = 200;
+  tone->attack = 5;
+  tone->release = 50;
+
+  if (!parse_frequency (frequency, GSOUND_ATTR_GSOUND_TONE_FREQUENCY,
+                        &tone->frequency, error))
+    return FALSE;
+
+  tone->frequency_end = tone->frequency;
+  if (frequency_end &&
+      !parse_frequency (frequency_end, GSOUND_ATTR_GSOUND_TONE_FREQUENCY_END,
+                        &tone->frequency_end, error))
+    return FALSE;
+
+  if (waveform)
+    {
+      for (i = 0; i < G_N_ELEMENTS (waveform_names); i++)
+        if (strcmp (waveform, waveform_names[i]) == 0)
+          break;
+
+      if (i == G_N_ELEMENTS (waveform_names))
+        {
+          g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_INVALID,
+                       "Invalid value “%s” for attribute “%s”",
+                       waveform, GSOUND_ATTR_GSOUND_TONE_WAVEFORM);
+          return FALSE;
+        }
+
+      tone->waveform = i;
+    }
+
+  return parse_ms (duration, GSOUND_ATTR_GSOUND_TONE_DURATION, MAX_DURATION,
+                   &tone->duration, error) &&
+         parse_ms (attack, GSOUND_ATTR_GSOUND_TONE_ATTACK, MAX_DURATION,
+                   &tone->attack, error) &&
+         parse_ms (release, GSOUND_ATTR_GSOUND_TONE_RELEASE, MAX_DURATION,
+                   &tone->release, error);
+}
+
+/* The kernels below take the phase of each frame as a fraction of a cycle
+ * in [0, 1). They have no loop-carried state, so the compiler can turn them
+ * into SIMD code. */
+
+static void
+kernel_sine (const float *phase,
+             float       *out,
+             gsize        n)
+{
+  gsize i;
+
+  for (i = 0; i < n; i++)
+    {
+      /* sin (2πp) = -sin (2πx) for x = p - 1/2, folded onto [-1/4, 1/4]
+       * where the Taylor series to z⁹ is within 4e-6 */
+      float x = phase[i] - 0.5f;
+      float z, z2;
+
+      x = x > 0.25f ? 0.5f - x : x;
+      x = x < -0.25f ? -0.5f - x : x;
+
+      z = x * (float) (2 * G_PI);
+      z2 = z * z;
+      out[i] = -z * (1.0f + z2 * (-1.0f / 6 +
+                                  z2 * (1.0f / 120 +
+                                        z2 * (-1.0f / 5040 +
+                                              z2 * (1.0f / 362880)))));
+    }
+}
+
+/* Polynomial band-limited step correction for a discontinuity at phase 0,
+ * where @dt is the phase increment per frame. This removes most of the
+ * aliasing of the naive square and sawtooth waves. */
+static inline float
+poly_blep (float t,
+           float dt)
+{
+  if (t < dt)
+    {
+      t /= dt;
+      return t + t - t * t - 1.0f;
+    }
+  else if (t > 1.0f - dt)
+    {
+      t = (t - 1.0f) / dt;
+      return t * t + t + t + 1.0f;
+    }
+
+  return 0.0f;
+}
+
+static void
+kernel_square (const float *phase,
+               const float *dt,
+               float       *out,
+               gsize        n)
+{
+  gsize i;
+
+  for (i = 0; i < n; i++)
+    {
+      float half = phase[i] < 0.5f ? phase[i] + 0.5f : phase[i] - 0.5f;
+
+      out[i] = (phase[i] < 0.5f ? 1.0f : -1.0f) +
+               poly_blep (phase[i], dt[i]) - poly_blep (half, dt[i]);
+    }
+}
+
+static void
+kernel_triangle (const float *phase,
+                 float       *out,
+                 gsize        n)
+{
+  gsize i;
+
+  for (i = 0; i < n; i++)
+    out[i] = 1.0f - 4.0f * fabsf (phase[i] - 0.5f);
+}
+
+static void
+kernel_sawtooth (const float *phase,
+                 const float *dt,
+                 float       *out,
+                 gsize        n)
+{
+  gsize i;
+
+  for (i = 0; i < n; i++)
+    out[i] = 2.0f * phase[i] - 1.0f - poly_blep (phase[i], dt[i]);
+}
+
+/*
+ * gsound_tone_render:
+ * @tone: a #GSoundTone
+ * @rate: sample rate in Hz
+ *
+ * Synthesizes @tone as a mono clip.
+ *
+ * Returns: (transfer full): the clip
+ */
+GSoundClip *
+gsound_tone_render (const GSoundTone *tone,
+                    guint             rate)
+{
+  gsize n_frames = (gsize) tone->duration * rate / 1000;
+  float n_attack = MAX ((float) tone->attack * rate / 1000, 1.0f);
+  float n_release = MAX ((float) tone->release * rate / 1000, 1.0f);
+  double start_step = tone->frequency / rate;
+  double sweep = 0.0;
+  GSoundClip *clip;
+  gsize start;
+
+  /* Change in phase increment per frame of a linear chirp */
+  if (n_frames > 0)
+    sweep = (tone->frequency_end - tone->frequency) / rate / n_frames;
+
+  clip = gsound_clip_new (rate, 1, n_frames);
+
+  for (start = 0; start < n_frames; start += BLOCK_SIZE)
+    {
+      gsize n = MIN (BLOCK_SIZE, n_frames - start);
+      float *out = clip->samples + start;
+      float phase[BLOCK_SIZE];
+      float dt[BLOCK_SIZE];
+      gsize i;
+
+      /* The phase is computed from the frame index rather than accumulated,
+       * in double precision so that long tones stay in tune */
+      for (i = 0; i < n; i++)
+        {
+          double x = (double) (start + i);
+          double p = x * (start_step + 0.5 * sweep * x);
+
+          phase[i] = (float) (p - floor (p));
+          dt[i] = (float) (start_step + sweep * x);
+        }
+
+      switch (tone->waveform)
+        {
+        case GSOUND_WAVEFORM_SINE:
+          kernel_sine (phase, out, n);
+          break;
+
+        case GSOUND_WAVEFORM_SQUARE:
+          kernel_square (phase, dt, out, n);
+          break;
+
+        case GSOUND_WAVEFORM_TRIANGLE:
+          kernel_triangle (phase, out, n);
+          break;
+
+        case GSOUND_WAVEFORM_SAWTOOTH:
+          kernel_sawtooth (phase, dt, out, n);
+          break;
+
+        default:
+          g_assert_not_reached ();
+        }
+
+      /* Linear attack and release */
+      for (i = 0; i < n; i++)
+        {
+          float attack = (start + i) / n_attack;
+          float release = (n_frames - start - i) / n_release;
+
+          out[i] *= TONE_GAIN * MIN (1.0f, MIN (attack, release));
+        }
+    }
+
+  return clip;
+}
+
+/*
+ * gsound_tone_to_string:
+ * @tone: a #GSoundTone
+ *
+ * Returns: (transfer full): a string which describes @tone completely,
+ *   and is suitable for use in file names
+ */
+char *
+gsound_tone_to_string (const GSoundTone *tone)
+{
+  char frequency[G_ASCII_DTOSTR_BUF_SIZE];
+  char frequency_end[G_ASCII_DTOSTR_BUF_SIZE];
+
+  return g_strdup_printf ("%s-%s-%s-%u-%u-%u",
+                          waveform_names[tone->waveform],
+                          g_ascii_dtostr (frequency, sizeof frequency,
+                                          tone->frequency),
+                          g_ascii_dtostr (frequency_end, sizeof frequency_end,
+                                          tone->frequency_end),
+                          tone->duration, tone->attack, tone->release);
+}
+
+/* A synthesized tone made available to libcanberra as a file. Where
+ * possible the file is anonymous and only exists in memory for as long as
+ * it is referenced; otherwise it is written to the user's runtime
+ * directory under a name of this process's own, and removed again. */
+struct _GSoundToneFile
+{
+  gint   ref_count;
+  char  *key;
+  char  *path;
+  int    fd;
+  gsize  size;
+  GList  link;
+};
+
+/* Most bytes of tone files kept for reuse by later plays; a file is only
+ * freed once the plays still using it let go of it */
+#define MAX_TONE_CACHE_SIZE (8 * 1024 * 1024)
+
+/* Under the lock: the files by gsound_tone_to_string(), each holding a
+ * reference, from least to most recently used, and their total size */
+static GMutex tone_lock;
+static GHashTable *tone_files;
+static GQueue tone_lru = G_QUEUE_INIT;
+static gsize tone_cache_size;
+
+static GBytes *
+render_tone_wav (const GSoundTone *tone)
+{
+  GSoundVoice voice = GSOUND_VOICE_INIT;
+  GSoundMixer *mixer;
+  GSoundClip *clip;
+  GBytes *pcm, *wav;
+
+  clip = gsound_tone_render (tone, GSOUND_TONE_RATE);
+  mixer = gsound_mixer_new (GSOUND_TONE_RATE, 1);
+  gsound_mixer_add (mixer, clip, &voice);
+  pcm = gsound_mixer_to_s16 (mixer);
+  wav = gsound_clip_encode_wav (GSOUND_TONE_RATE, 1, pcm);
+
+  g_bytes_unref (pcm);
+  gsound_mixer_free (mixer);
+  gsound_clip_unref (clip);
+
+  return wav;
+}
+
+#ifdef HAVE_MEMFD_CREATE
+static gboolean
+write_tone_file (GSoundToneFile  *file,
+                 GBytes          *wav,
+                 GError         **error)
+{
+  const guint8 *data;
+  gsize size;
+  int saved_errno;
+
+  data = g_bytes_get_data (wav, &size);
+
+  file->fd = memfd_create ("gsound-tone", MFD_CLOEXEC);
+  if (file->fd < 0)
+    goto fail;
+
+  while (size > 0)
+    {
+      gssize n = write (file->fd, data, size);
+
+      if (n < 0 && errno == EINTR)
+        continue;
+      else if (n < 0)
+        goto fail;
+
+      data += n;
+      size -= n;
+    }
+
+  /* libcanberra opens the file by name in this process */
+  file->path = g_strdup_printf ("/proc/self/fd/%d", file->fd);
+
+  return TRUE;
+
+fail:
+  saved_errno = errno;
+  g_set_error (error, GSOUND_ERROR, GSOUND_ERROR_IO,
+               "Could not create tone file: %s", g_strerror (saved_errno));
+
+  return FALSE;
+}
+#else
+static gboolean
+write_tone_file (GSoundToneFile  *file,
+                 GBytes          *wav,
+                 GError         **error)
+{
+  GError *inner_error = NULL;
+  gconstpointer data;
+  gsize size;
+  char *dir, *name;
+
+  dir = g_build_filename (g_get_user_runtime_dir (), "gsound", NULL);
+  g_mkdir_with_parents (dir, 0700);
+  name = g_strdup_printf ("tone-%d-%s.wav", (int) getpid (), file->key);
+  file->path = g_build_filename (dir, name, NULL);
+  g_free (name);
+  g_free (dir);
+
+  data = g_bytes_get_data (wav, &size);
+  if (!g_file_set_contents (file->path, data, size, &inner_error))
+    {
+      g_set_error_literal (error, GSOUND_ERROR, GSOUND_ERROR_IO,
+                           inner_error->message);
+      g_error_free (inner_error);
+      g_clear_pointer (&file->path, g_free);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+#endif
+
+/*
+ * gsound_tone_file_ref:
+ * @file: a #GSoundToneFile
+ *
+ * Returns: (transfer full): @file
+ */
+GSoundToneFile *
+gsound_tone_file_ref (GSoundToneFile *file)
+{
+  g_atomic_int_inc (&file->ref_count);
+  return file;
+}
+
+/*
+ * gsound_tone_file_unref:
+ * @file: a #GSoundToneFile
+ *
+ * Drops a reference to @file, removing the file with the last one.
+ */
+void
+gsound_tone_file_unref (GSoundToneFile *file)
+{
+  if (!g_atomic_int_dec_and_test (&file->ref_count))
+    return;
+
+#ifdef HAVE_MEMFD_CREATE
+  if (file->fd >= 0)
+    close (file->fd);
+#else
+  if (file->path)
+    g_unlink (file->path);
+#endif
+
+  g_free (file->path);
+  g_free (file->key);
+  g_slice_free (GSoundToneFile, file);
+}
+
+/*
+ * gsound_tone_file_get_path:
+ * @file: a #GSoundToneFile
+ *
+ * Returns: the name to pass to libcanberra, valid for as long as @file
+ */
+const char *
+gsound_tone_file_get_path (GSoundToneFile *file)
+{
+  return file->path;
+}
+
+/* Called with the lock held */
+static void
+tone_cache_evict (void)
+{
+  while (tone_cache_size > MAX_TONE_CACHE_SIZE && tone_lru.length > 1)
+    {
+      GSoundToneFile *file = g_queue_peek_head (&tone_lru);
+
+      g_queue_unlink (&tone_lru, &file->link);
+      g_hash_table_remove (tone_files, file->key);
+      tone_cache_size -= file->size;
+      gsound_tone_file_unref (file);
+    }
+}
+
+/*
+ * gsound_tone_get_file:
+ * @tone: a #GSoundTone
+ * @error: Return location for error
+ *
+ * libcanberra can only play files, so tones played through the sound
+ * server are synthesized into a file, which is reused by later plays of
+ * the same tone while it is among the most recently used ones. Tones are
+ * synthesized without holding any lock, so a tone first played on two
+ * threads at once may be synthesized twice.
+ *
+ * Returns: (transfer full): the file, or %NULL on error
+ */
+GSoundToneFile *
+gsound_tone_get_file (const GSoundTone  *tone,
+                      GError           **error)
+{
+  GSoundToneFile *file, *existing;
+  char *key;
+  GBytes *wav;
+
+  key = gsound_tone_to_string (tone);
+
+  g_mutex_lock (&tone_lock);
+
+  if (!tone_files)
+    tone_files = g_hash_table_new (g_str_hash, g_str_equal);
+
+  file = g_hash_table_lookup (tone_files, key);
+  if (file)
+    {
+      g_queue_unlink (&tone_lru, &file->link);
+      g_queue_push_tail_link (&tone_lru, &file->link);
+      gsound_tone_file_ref (file);
+      g_mutex_unlock (&tone_lock);
+      g_free (key);
+      return file;
+    }
+
+  g_mutex_unlock (&tone_lock);
+
+  file = g_slice_new0 (GSoundToneFile);
+  file->ref_count = 1;
+  file->key = key;
+  file->fd = -1;
+  file->link.data = file;
+
+  wav = render_tone_wav (tone);
+  file->size = g_bytes_get_size (wav);
+  if (!write_tone_file (file, wav, error))
+    {
+      g_bytes_unref (wav);
+      gsound_tone_file_unref (file);
+      return NULL;
+    }
+  g_bytes_unref (wav);
+
+  g_mutex_lock (&tone_lock);
+
+  existing = g_hash_table_lookup (tone_files, key);
+  if (existing)
+    {
+      gsound_tone_file_ref (existing);
+      g_mutex_unlock (&tone_lock);
+      gsound_tone_file_unref (file);
+      return existing;
+    }
+
+  /* The cache's reference */
+  g_hash_table_insert (tone_files, file->key, gsound_tone_file_ref (file));
+  g_queue_push_tail_link (&tone_lru, &file->link);
+  tone_cache_size += file->size;
+  tone_cache_evict ();
+
+  g_mutex_unlock (&tone_lock);
+
+  return file;
+}
@@ -0,0 +1,127 @@
+/* gsound-trace-private.h
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef GSOUND_TRACE_PRIVATE_H
+#define GSOUND_TRACE_PRIVATE_H
+
+#include <glib.h>
+
+/*
+ * Static tracepoints on the play path, enabled with -Dtracing=true.
+ *
+ * With <sys/sdt.h> each tracepoint is a USDT probe in the "gsound"
+ * provider, visible to perf, bpftrace and SystemTap, which costs a single
+ * nop when not traced. With sysprof-capture each tracepoint also records a
+ * mark, which is a no-op unless a sysprof collector is active.
+ *
+ * Times are monotonic microseconds from g_get_monotonic_time().
+ *
+ * Probes:
+ *   gsound:play__submit    (id, event_id)
+ *   gsound:play__proplist  (id, duration)
+ *   gsound:play__backend   (id, duration, result)
+ *   gsound:play__complete  (id, duration, result, timed_out)
+ *   gsound:play__cancel    (id)
+ */
+
+#ifdef HAVE_SYS_SDT_H
+# include <sys/sdt.h>
+# define GSOUND_TRACE_ENABLED 1
+# define GSOUND_PROBE1(name, a)       DTRACE_PROBE1 (gsound, name, a)
+# define GSOUND_PROBE2(name, a, b)    DTRACE_PROBE2 (gsound, name, a, b)
+# define GSOUND_PROBE3(name, a, b, c) DTRACE_PROBE3 (gsound, name, a, b, c)
+# define GSOUND_PROBE4(name, a, b, c, d) DTRACE_PROBE4 (gsound, name, a, b, c, d)
+#else
+# define GSOUND_PROBE1(name, a)
+# define GSOUND_PROBE2(name, a, b)
+# define GSOUND_PROBE3(name, a, b, c)
+# define GSOUND_PROBE4(name, a, b, c, d)
+#endif
+
+#ifdef HAVE_SYSPROF
+# include <sysprof-capture.h>
+# ifndef GSOUND_TRACE_ENABLED
+#  define GSOUND_TRACE_ENABLED 1
+# endif
+# define GSOUND_MARK(begin, name, ...) \
+  sysprof_collector_mark_printf ((begin) * 1000, \
+                                 (g_get_monotonic_time () - (begin)) * 1000, \
+                                 "gsound", name, __VA_ARGS__)
+#else
+# define GSOUND_MARK(begin, name, ...)
+#endif
+
+#ifdef GSOUND_TRACE_ENABLED
+# define GSOUND_TRACE_TIME() g_get_monotonic_time ()
+#else
+# define GSOUND_TRACE_TIME() 0
+#endif
+
+#define GSOUND_TRACE_SUBMIT(id, event_id) \
+  G_STMT_START { \
+    GSOUND_PROBE2 (play__submit, id, event_id); \
+  } G_STMT_END
+
+#define GSOUND_TRACE_PROPLIST(id, begin) \
+  G_STMT_START { \
+    GSOUND_PROBE2 (play__proplist, id, GSOUND_TRACE_TIME () - (begin)); \
+    GSOUND_MARK (begin, "proplist", "id %u", id); \
+  } G_STMT_END
+
+#define GSOUND_TRACE_BACKEND(id, begin, result) \
+  G_STMT_START { \
+    GSOUND_PROBE3 (play__backend, id, GSOUND_TRACE_TIME () - (begin), result); \
+    GSOUND_MARK (begin, "backend", "id %u result %d", id, result); \
+  } G_STMT_END
+
+#define GSOUND_TRACE_COMPLETE(id, begin, result, timed_out) \
+  G_STMT_START { \
+    GSOUND_PROBE4 (play__complete, id, GSOUND_TRACE_TIME () - (begin), \
+                   result, timed_out); \
+    GSOUND_MARK (begin, "play", "id %u result %d%s", id, result, \
+                 (timed_out) ? " (timed out)" : ""); \
+  } G_STMT_END
+
+#define GSOUND_TRACE_CANCEL(id) \
+  G_STMT_START { \
+    GSOUND_PROBE1 (play__cancel, id); \
+  } G_STMT_END
+
+G_BEGIN_DECLS
+
+/* Chrome trace event log, enabled at runtime with GSOUND_TRACE=path */
+gboolean gsound_trace_log_enabled (void);
+
+void     gsound_trace_log_submit  (guint32             id,
+                                   const char         *name,
+                                   const char * const *attrs,
+                                   guint               n_attrs);
+
+void     gsound_trace_log_mark    (guint32             id,
+                                   const char         *name,
+                                   const char         *key,
+                                   gint64              value);
+
+void     gsound_trace_log_end     (guint32             id,
+                                   const char         *name,
+                                   const char         *result,
+                                   const char         *message);
+
+G_END_DECLS
+
+#endif /* GSOUND_TRACE_PRIVATE_H */
@@ -0,0 +1,243 @@
+/* gsound-trace.c
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "gsound-trace-private.h"
+
+#include <stdio.h>
+#include <unistd.h>
+
+/*
+ * A play timeline log in the Chrome trace event format, written to the
+ * file named by the GSOUND_TRACE environment variable and readable by
+ * Perfetto and chrome://tracing.
+ *
+ * Each play is an async slice ("b"/"e" events keyed by the play id) named
+ * after its event id, with instant ("n") events for what happens to it in
+ * between. The JSON array is left unterminated, which the format allows,
+ * so the file stays valid however the process exits.
+ */
+
+static FILE *trace_file;
+static gboolean trace_first = TRUE;
+static GMutex trace_lock;
+static GPrivate trace_tid;
+static gint trace_next_tid;
+
+gboolean
+gsound_trace_log_enabled (void)
+{
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      const char *path = g_getenv ("GSOUND_TRACE");
+
+      if (path && *path)
+        {
+          trace_file = fopen (path, "w");
+          if (trace_file)
+            {
+              setvbuf (trace_file, NULL, _IOLBF, 0);
+              fputs ("[", trace_file);
+            }
+          else
+            g_warning ("Could not open GSOUND_TRACE file “%s”", path);
+        }
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return trace_file != NULL;
+}
+
+static gint
+get_tid (void)
+{
+  gint tid = GPOINTER_TO_INT (g_private_get (&trace_tid));
+
+  if (tid == 0)
+    {
+      tid = g_atomic_int_add (&trace_next_tid, 1) + 1;
+      g_private_set (&trace_tid, GINT_TO_POINTER (tid));
+    }
+
+  return tid;
+}
+
+static void
+append_json_string (GString    *str,
+                    const char *s)
+{
+  g_string_append_c (str, '"');
+
+  for (; *s; s++)
+    {
+      switch (*s)
+        {
+        case '"':
+          g_string_append (str, "\\\"");
+          break;
+        case '\\':
+          g_string_append (str, "\\\\");
+          break;
+        case '\n':
+          g_string_append (str, "\\n");
+          break;
+        default:
+          if ((guchar) *s < 0x20)
+            g_string_append_printf (str, "\\u%04x", (guchar) *s);
+          else
+            g_string_append_c (str, *s);
+        }
+    }
+
+  g_string_append_c (str, '"');
+}
+
+static GString *
+event_new (char        phase,
+           guint32     id,
+           const char *name)
+{
+  GString *str = g_string_sized_new (256);
+
+  g_string_append_printf (str,
+                          "{\"ph\":\"%c\",\"cat\":\"gsound\",\"id\":\"0x%x\","
+                          "\"pid\":%d,\"tid\":%d,"
+                          "\"ts\":%" G_GINT64_FORMAT ",\"name\":",
+                          phase, id, (int) getpid (), get_tid (),
+                          g_get_monotonic_time ());
+  append_json_string (str, name ? name : "play");
+
+  return str;
+}
+
+static void
+event_write (GString *str)
+{
+  g_string_append (str, "}\n");
+
+  g_mutex_lock (&trace_lock);
+  if (!trace_first)
+    fputc (',', trace_file);
+  trace_first = FALSE;
+  fputs (str->str, trace_file);
+  g_mutex_unlock (&trace_lock);
+
+  g_string_free (str, TRUE);
+}
+
+/*
+ * gsound_trace_log_submit:
+ * @id: the play id
+ * @name: (nullable): the event id of the play
+ * @attrs: key/value pairs of the play's attributes
+ * @n_attrs: the number of pairs in @attrs
+ *
+ * Opens the slice for a play.
+ */
+void
+gsound_trace_log_submit (guint32             id,
+                         const char         *name,
+                         const char * const *attrs,
+                         guint               n_attrs)
+{
+  GString *str;
+  guint i;
+
+  if (G_LIKELY (!gsound_trace_log_enabled ()))
+    return;
+
+  str = event_new ('b', id, name);
+  g_string_append (str, ",\"args\":{");
+  for (i = 0; i < n_attrs; i++)
+    {
+      if (i > 0)
+        g_string_append_c (str, ',');
+      append_json_string (str, attrs[2 * i]);
+      g_string_append_c (str, ':');
+      append_json_string (str, attrs[2 * i + 1]);
+    }
+  g_string_append_c (str, '}');
+
+  event_write (str);
+}
+
+/*
+ * gsound_trace_log_mark:
+ * @id: the play id
+ * @name: the name of the instant event
+ * @key: (nullable): name of an integer argument
+ * @value: the value of @key
+ *
+ * Records an instant event within the slice of a play.
+ */
+void
+gsound_trace_log_mark (guint32     id,
+                       const char *name,
+                       const char *key,
+                       gint64      value)
+{
+  GString *str;
+
+  if (G_LIKELY (!gsound_trace_log_enabled ()))
+    return;
+
+  str = event_new ('n', id, name);
+  if (key)
+    {
+      g_string_append (str, ",\"args\":{");
+      append_json_string (str, key);
+      g_string_append_printf (str, ":%" G_GINT64_FORMAT "}", value);
+    }
+
+  event_write (str);
+}
+
+/*
+ * gsound_trace_log_end:
+ * @id: the play id
+ * @name: (nullable): the event id of the play, as passed when submitted
+ * @result: "finished", "cancelled", "timed-out" or "error"
+ * @message: (nullable): an error message
+ *
+ * Closes the slice for a play.
+ */
+void
+gsound_trace_log_end (guint32     id,
+                      const char *name,
+                      const char *result,
+                      const char *message)
+{
+  GString *str;
+
+  if (G_LIKELY (!gsound_trace_log_enabled ()))
+    return;
+
+  str = event_new ('e', id, name);
+  g_string_append (str, ",\"args\":{\"result\":");
+  append_json_string (str, result);
+  if (message)
+    {
+      g_string_append (str, ",\"message\":");
+      append_json_string (str, message);
+    }
+  g_string_append_c (str, '}');
+
+  event_write (str);
+}
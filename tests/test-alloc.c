@@ -0,0 +1,278 @@
+/* test-alloc.c
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Allocation budgets of the play and cache paths. The test binary
+ * interposes the allocator to count the blocks allocated on any thread,
+ * GSound's and libcanberra's alike, while a path is called many times
+ * against the null driver. A path going over its budget, or keeping
+ * memory once its plays are done, fails the test. */
+
+#include <gsound.h>
+
+#include <stdlib.h>
+
+/* Allocations per call, including the completion of the play. Raise a
+ * budget only together with the change which needs it. */
+#define BUDGET_PLAY_SIMPLE  40
+#define BUDGET_PLAY_SIMPLEV 40
+#define BUDGET_PLAY_FULL    56
+#define BUDGET_CACHEV       24
+
+/* Calls made before counting, for thread pools, caches and hash tables to
+ * reach their steady state */
+#define N_WARMUP 200
+
+#define N_CALLS 1000
+
+extern void *__libc_malloc  (size_t size);
+extern void *__libc_calloc  (size_t n, size_t size);
+extern void *__libc_realloc (void *ptr, size_t size);
+extern void  __libc_free    (void *ptr);
+
+static gint counting;
+static gint n_allocs;
+static gint n_frees;
+
+void *
+malloc (size_t size)
+{
+  if (g_atomic_int_get (&counting))
+    g_atomic_int_inc (&n_allocs);
+
+  return __libc_malloc (size);
+}
+
+void *
+calloc (size_t n,
+        size_t size)
+{
+  if (g_atomic_int_get (&counting))
+    g_atomic_int_inc (&n_allocs);
+
+  return __libc_calloc (n, size);
+}
+
+/* Moving a block counts as allocating a new one and freeing the old */
+void *
+realloc (void   *ptr,
+         size_t  size)
+{
+  if (g_atomic_int_get (&counting))
+    {
+      if (size > 0)
+        g_atomic_int_inc (&n_allocs);
+      if (ptr)
+        g_atomic_int_inc (&n_frees);
+    }
+
+  return __libc_realloc (ptr, size);
+}
+
+void
+free (void *ptr)
+{
+  if (ptr && g_atomic_int_get (&counting))
+    g_atomic_int_inc (&n_frees);
+
+  __libc_free (ptr);
+}
+
+typedef struct
+{
+  GSoundContext *context;
+  GHashTable    *attrs;
+  guint          n_called;
+  guint          n_done;
+} Fixture;
+
+typedef void (*CallFunc) (Fixture *fixture);
+
+static void
+call_play_simple (Fixture *fixture)
+{
+  g_assert_true (gsound_context_play_simple (fixture->context, NULL, NULL,
+                                             GSOUND_ATTR_EVENT_ID, "bell",
+                                             NULL));
+}
+
+static void
+call_play_simplev (Fixture *fixture)
+{
+  g_assert_true (gsound_context_play_simplev (fixture->context,
+                                              fixture->attrs, NULL, NULL));
+}
+
+static void
+on_played (GObject      *source,
+           GAsyncResult *result,
+           gpointer      user_data)
+{
+  Fixture *fixture = user_data;
+
+  g_assert_true (gsound_context_play_full_finish (GSOUND_CONTEXT (source),
+                                                  result, NULL));
+  fixture->n_done++;
+}
+
+static void
+call_play_full (Fixture *fixture)
+{
+  gsound_context_play_full (fixture->context, NULL, on_played, fixture,
+                            GSOUND_ATTR_EVENT_ID, "bell",
+                            NULL);
+}
+
+/* The null driver may not support caching, which costs a GError per call
+ * that the budget allows for */
+static void
+call_cachev (Fixture *fixture)
+{
+  GError *error = NULL;
+
+  if (!gsound_context_cachev (fixture->context, fixture->attrs, &error))
+    {
+      g_assert_error (error, GSOUND_ERROR, GSOUND_ERROR_NOTSUPPORTED);
+      g_error_free (error);
+    }
+
+  fixture->n_done++;
+}
+
+/* Waits for everything started by the calls so far to finish */
+static void
+drain (Fixture  *fixture,
+       CallFunc  func)
+{
+  GSoundStats stats;
+
+  while (TRUE)
+    {
+      while (g_main_context_iteration (NULL, FALSE))
+        ;
+
+      gsound_context_get_stats (fixture->context, &stats);
+      if (stats.submitted == stats.completed + stats.failed +
+                             stats.timed_out + stats.cancelled &&
+          (func == call_play_simple || func == call_play_simplev ||
+           fixture->n_done == fixture->n_called))
+        break;
+
+      g_usleep (1000);
+    }
+}
+
+static void
+run_calls (Fixture  *fixture,
+           CallFunc  func,
+           guint     n)
+{
+  guint i;
+
+  for (i = 0; i < n; i++)
+    {
+      fixture->n_called++;
+      func (fixture);
+    }
+
+  drain (fixture, func);
+}
+
+static void
+check_budget (CallFunc  func,
+              guint     budget)
+{
+  Fixture fixture = { NULL, };
+  double per_call;
+  gint live;
+
+  fixture.context = gsound_context_new (NULL, NULL);
+  if (!fixture.context ||
+      !gsound_context_set_driver (fixture.context, "null", NULL) ||
+      !gsound_context_open (fixture.context, NULL))
+    {
+      g_clear_object (&fixture.context);
+      g_test_skip ("libcanberra has no null driver");
+      return;
+    }
+
+  fixture.attrs = g_hash_table_new (g_str_hash, g_str_equal);
+  g_hash_table_insert (fixture.attrs, GSOUND_ATTR_EVENT_ID, "bell");
+
+  run_calls (&fixture, func, N_WARMUP);
+
+  g_atomic_int_set (&n_allocs, 0);
+  g_atomic_int_set (&n_frees, 0);
+  g_atomic_int_set (&counting, TRUE);
+
+  run_calls (&fixture, func, N_CALLS);
+
+  g_atomic_int_set (&counting, FALSE);
+
+  per_call = (double) g_atomic_int_get (&n_allocs) / N_CALLS;
+  live = g_atomic_int_get (&n_allocs) - g_atomic_int_get (&n_frees);
+
+  g_test_message ("%.1f allocations per call, budget %u, %d blocks kept",
+                  per_call, budget, live);
+
+  g_assert_cmpfloat (per_call, <=, budget);
+
+  /* Anything kept by every call adds up to at least a block per call;
+   * less is a pool or cache that grew, or a reference still being
+   * dropped by the worker */
+  g_assert_cmpint (live, <, N_CALLS);
+
+  g_hash_table_unref (fixture.attrs);
+  g_object_unref (fixture.context);
+}
+
+static void
+test_alloc_play_simple (void)
+{
+  check_budget (call_play_simple, BUDGET_PLAY_SIMPLE);
+}
+
+static void
+test_alloc_play_simplev (void)
+{
+  check_budget (call_play_simplev, BUDGET_PLAY_SIMPLEV);
+}
+
+static void
+test_alloc_play_full (void)
+{
+  check_budget (call_play_full, BUDGET_PLAY_FULL);
+}
+
+static void
+test_alloc_cachev (void)
+{
+  check_budget (call_cachev, BUDGET_CACHEV);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/alloc/play-simple", test_alloc_play_simple);
+  g_test_add_func ("/alloc/play-simplev", test_alloc_play_simplev);
+  g_test_add_func ("/alloc/play-full", test_alloc_play_full);
+  g_test_add_func ("/alloc/cachev", test_alloc_cachev);
+
+  return g_test_run ();
+}
@@ -0,0 +1,324 @@
+/* test-fault.c
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* Stress tests of GSound against a sound server made to misbehave by
+ * GSOUND_FAULT. The fault spec is read once per process, so each test
+ * runs in a subprocess of its own with the spec it needs. */
+
+#include <gsound.h>
+
+#include <gio/gio.h>
+
+/* Calls made before the backend is usable also go through the fault
+ * injection, and are retried up to this many times */
+#define MAX_ATTEMPTS 100
+
+#define N_PLAYS 200
+
+typedef struct
+{
+  guint n_done;
+  guint n_ok;
+  guint n_failed;
+  guint n_timed_out;
+  guint n_cancelled;
+  GQuark error_domain;
+  int error_code;
+} Results;
+
+static gboolean
+null_driver_available (void)
+{
+  GSoundContext *context;
+  gboolean ok;
+
+  context = gsound_context_new (NULL, NULL);
+  if (!context)
+    return FALSE;
+
+  ok = gsound_context_set_driver (context, "null", NULL) &&
+       gsound_context_open (context, NULL);
+  g_object_unref (context);
+
+  return ok;
+}
+
+/* Runs the current test in a subprocess with GSOUND_FAULT set to @spec,
+ * returning TRUE in the subprocess */
+static gboolean
+run_with_faults (const char *spec)
+{
+  if (g_test_subprocess ())
+    {
+      g_setenv ("GSOUND_FAULT", spec, TRUE);
+      return TRUE;
+    }
+
+  if (!null_driver_available ())
+    {
+      g_test_skip ("libcanberra has no null driver");
+      return FALSE;
+    }
+
+  g_test_trap_subprocess (NULL, 0, 0);
+  g_test_trap_assert_passed ();
+
+  return FALSE;
+}
+
+static GSoundContext *
+new_context (void)
+{
+  GSoundContext *context = NULL;
+  GError *error = NULL;
+  guint i;
+
+  for (i = 0; !context && i < MAX_ATTEMPTS; i++)
+    {
+      context = gsound_context_new (NULL, &error);
+      g_clear_error (&error);
+    }
+  g_assert_nonnull (context);
+
+  g_assert_true (gsound_context_set_driver (context, "null", NULL));
+
+  for (i = 0; i < MAX_ATTEMPTS; i++)
+    {
+      if (gsound_context_open (context, &error))
+        return context;
+
+      g_assert_false (g_error_matches (error, GSOUND_ERROR,
+                                       GSOUND_ERROR_NODRIVER));
+      g_clear_error (&error);
+    }
+
+  g_assert_not_reached ();
+}
+
+static void
+on_played (GObject      *source,
+           GAsyncResult *result,
+           gpointer      user_data)
+{
+  Results *results = user_data;
+  GError *error = NULL;
+
+  if (gsound_context_play_full_finish (GSOUND_CONTEXT (source), result,
+                                       &error))
+    results->n_ok++;
+  else if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT))
+    results->n_timed_out++;
+  else if (g_error_matches (error, GSOUND_ERROR, GSOUND_ERROR_CANCELED))
+    results->n_cancelled++;
+  else
+    {
+      g_assert_error (error, results->error_domain, results->error_code);
+      results->n_failed++;
+    }
+
+  g_clear_error (&error);
+  results->n_done++;
+}
+
+static void
+play_many (GSoundContext *context,
+           Results       *results)
+{
+  guint i;
+
+  for (i = 0; i < N_PLAYS; i++)
+    gsound_context_play_full (context, NULL, on_played, results,
+                              GSOUND_ATTR_EVENT_ID, "bell",
+                              NULL);
+
+  while (results->n_done < N_PLAYS)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static void
+assert_stats_match (GSoundContext *context,
+                    Results       *results)
+{
+  GSoundStats stats;
+
+  gsound_context_get_stats (context, &stats);
+
+  g_assert_cmpuint (stats.submitted, ==, results->n_done);
+  g_assert_cmpuint (stats.completed, ==, results->n_ok);
+  g_assert_cmpuint (stats.failed, ==, results->n_failed);
+  g_assert_cmpuint (stats.timed_out, ==, results->n_timed_out);
+  g_assert_cmpuint (stats.cancelled, ==, results->n_cancelled);
+  g_assert_cmpuint (stats.submitted, ==,
+                    stats.completed + stats.failed + stats.timed_out +
+                    stats.cancelled);
+}
+
+/* A failure to set up the context must be reported, and leave nothing
+ * behind */
+static void
+test_fault_init (void)
+{
+  GSoundContext *context;
+  GError *error = NULL;
+  guint i;
+
+  if (!run_with_faults ("error=oom,seed=1"))
+    return;
+
+  for (i = 0; i < N_PLAYS; i++)
+    {
+      context = gsound_context_new (NULL, &error);
+      g_assert_null (context);
+      g_assert_error (error, GSOUND_ERROR, GSOUND_ERROR_OOM);
+      g_clear_error (&error);
+    }
+}
+
+/* Failed calls are reported through each play, and counted */
+static void
+test_fault_errors (void)
+{
+  Results results = { 0, };
+  GSoundContext *context;
+
+  if (!run_with_faults ("error=disconnected,error-rate=0.5,seed=1"))
+    return;
+
+  results.error_domain = GSOUND_ERROR;
+  results.error_code = GSOUND_ERROR_DISCONNECTED;
+
+  context = new_context ();
+  play_many (context, &results);
+
+  g_assert_cmpuint (results.n_ok, >, 0);
+  g_assert_cmpuint (results.n_failed, >, 0);
+  g_assert_cmpuint (results.n_timed_out, ==, 0);
+  g_assert_cmpuint (results.n_cancelled, ==, 0);
+  assert_stats_match (context, &results);
+
+  g_object_unref (context);
+}
+
+/* Plays whose completion the server loses end with the timeout */
+static void
+test_fault_lost (void)
+{
+  Results results = { 0, };
+  GSoundContext *context;
+
+  if (!run_with_faults ("lost=0.5,seed=2"))
+    return;
+
+  context = new_context ();
+  gsound_context_set_timeout (context, 50);
+  play_many (context, &results);
+
+  g_assert_cmpuint (results.n_ok, >, 0);
+  g_assert_cmpuint (results.n_timed_out, >, 0);
+  g_assert_cmpuint (results.n_failed, ==, 0);
+  assert_stats_match (context, &results);
+
+  g_object_unref (context);
+}
+
+/* A slow server shows in the start latency */
+static void
+test_fault_latency (void)
+{
+  Results results = { 0, };
+  GSoundContext *context;
+
+  if (!run_with_faults ("latency=5,jitter=5,seed=3"))
+    return;
+
+  context = new_context ();
+  play_many (context, &results);
+
+  g_assert_cmpuint (results.n_ok, ==, N_PLAYS);
+  assert_stats_match (context, &results);
+  g_assert_cmpint (gsound_context_get_output_latency (context), >=, 5000);
+
+  g_object_unref (context);
+}
+
+/* Sounds are shed while the server fails, and once it has been left alone
+ * for a while the context recovers */
+static void
+test_fault_recovery (void)
+{
+  Results results = { 0, };
+  GSoundContext *context;
+  GSoundStats stats;
+  gint64 deadline;
+
+  if (!run_with_faults ("error=io,error-rate=0.9,seed=4"))
+    return;
+
+  results.error_domain = GSOUND_ERROR;
+  results.error_code = GSOUND_ERROR_IO;
+
+  context = new_context ();
+  gsound_context_set_qos_thresholds (context, 0, 0.25);
+
+  do
+    {
+      guint n_submitted = results.n_done + 1;
+
+      gsound_context_play_full (context, NULL, on_played, &results,
+                                GSOUND_ATTR_EVENT_ID, "bell",
+                                NULL);
+      while (results.n_done < n_submitted)
+        g_main_context_iteration (NULL, TRUE);
+
+      gsound_context_get_stats (context, &stats);
+      g_assert_cmpuint (stats.submitted, <, N_PLAYS);
+    }
+  while (stats.shed == 0);
+
+  g_assert_cmpuint (results.n_failed, >, 0);
+  g_assert_cmpuint (results.n_cancelled, ==, stats.shed);
+  assert_stats_match (context, &results);
+  g_assert_cmpint (stats.qos_level, ==, GSOUND_QOS_CRITICAL);
+
+  deadline = g_get_monotonic_time () + 20 * G_USEC_PER_SEC;
+  do
+    {
+      g_usleep (G_USEC_PER_SEC / 10);
+      gsound_context_get_stats (context, &stats);
+    }
+  while (stats.qos_level != GSOUND_QOS_NORMAL &&
+         g_get_monotonic_time () < deadline);
+
+  g_assert_cmpint (stats.qos_level, ==, GSOUND_QOS_NORMAL);
+
+  g_object_unref (context);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/fault/init", test_fault_init);
+  g_test_add_func ("/fault/errors", test_fault_errors);
+  g_test_add_func ("/fault/lost", test_fault_lost);
+  g_test_add_func ("/fault/latency", test_fault_latency);
+  g_test_add_func ("/fault/recovery", test_fault_recovery);
+
+  return g_test_run ();
+}
@@ -0,0 +1,234 @@
+/* test-soak.c
+ *
+ * Copyright (C) 2026 The GSound Authors
+ *
+ * This file is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2.1 of the
+ * License, or (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* A soak test which plays, cancels and caches sounds against the null
+ * driver for a long time, sampling the resident memory and the number of
+ * live GObjects as it goes, and fails if either keeps growing.
+ *
+ * GSOUND_SOAK_ITERATIONS sets the number of plays, by default enough for
+ * a run of a few seconds; set it to millions for a real soak. The object
+ * counts need GOBJECT_DEBUG=instance-count. */
+
+#include <gsound.h>
+
+#include <gio/gio.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#define DEFAULT_ITERATIONS 100000
+
+/* Plays submitted before waiting for them all to finish */
+#define BATCH_SIZE 64
+
+/* The first samples are taken as the process warms up, and the last ones
+ * are compared with the baseline set once it has */
+#define N_SAMPLES 20
+#define N_WARMUP_SAMPLES 2
+#define N_TAIL_SAMPLES 3
+
+/* Growth of the resident memory which is put down to the allocator */
+#define RSS_SLACK (8 * 1024 * 1024)
+
+typedef struct
+{
+  gsize rss;
+  guint n_objects;
+} Sample;
+
+static gsize
+get_rss (void)
+{
+  char *contents;
+  gsize rss = 0;
+  guint64 pages;
+
+  if (!g_file_get_contents ("/proc/self/statm", &contents, NULL, NULL))
+    return 0;
+
+  /* The second field is the resident set size in pages */
+  if (sscanf (contents, "%*u %" G_GUINT64_FORMAT, &pages) == 1)
+    rss = pages * sysconf (_SC_PAGESIZE);
+
+  g_free (contents);
+
+  return rss;
+}
+
+static guint
+get_n_objects (void)
+{
+  return g_type_get_instance_count (GSOUND_TYPE_CONTEXT) +
+         g_type_get_instance_count (G_TYPE_TASK) +
+         g_type_get_instance_count (G_TYPE_CANCELLABLE);
+}
+
+static void
+on_played (GObject      *source,
+           GAsyncResult *result,
+           gpointer      user_data)
+{
+  guint *n_pending = user_data;
+
+  /* Plays are cancelled at random, so either result will do */
+  gsound_context_play_full_finish (GSOUND_CONTEXT (source), result, NULL);
+  (*n_pending)--;
+}
+
+static void
+run_batch (GSoundContext *context,
+           GHashTable    *cache_attrs,
+           guint          batch)
+{
+  GCancellable *cancellables[BATCH_SIZE];
+  guint n_pending = BATCH_SIZE;
+  GSoundContext *child;
+  char tag[16];
+  guint i;
+
+  g_snprintf (tag, sizeof tag, "%u", batch % 4);
+
+  /* Children share their root's connection and bookkeeping */
+  child = gsound_context_new_child (context);
+
+  for (i = 0; i < BATCH_SIZE; i++)
+    {
+      cancellables[i] = g_cancellable_new ();
+      gsound_context_play_full (i % 2 ? child : context, cancellables[i],
+                                on_played, &n_pending,
+                                GSOUND_ATTR_EVENT_ID, "bell",
+                                GSOUND_ATTR_GSOUND_TAG, tag,
+                                NULL);
+    }
+
+  for (i = 0; i < BATCH_SIZE; i += 3)
+    g_cancellable_cancel (cancellables[i]);
+
+  gsound_context_cancel_matching (context, NULL,
+                                  GSOUND_ATTR_GSOUND_TAG, tag,
+                                  NULL);
+
+  /* Caching may not be supported by the null driver */
+  gsound_context_cachev (context, cache_attrs, NULL);
+
+  while (n_pending > 0)
+    g_main_context_iteration (NULL, TRUE);
+
+  for (i = 0; i < BATCH_SIZE; i++)
+    g_object_unref (cancellables[i]);
+
+  g_object_unref (child);
+}
+
+/* Growth is sustained if even the smallest of the last samples is beyond
+ * the baseline, so that a single spike does not fail the test */
+static void
+check_growth (const Sample *samples,
+              guint         n_samples)
+{
+  const Sample *baseline = &samples[N_WARMUP_SAMPLES];
+  gsize min_rss = G_MAXSIZE;
+  guint min_objects = G_MAXUINT;
+  guint i;
+
+  for (i = n_samples - N_TAIL_SAMPLES; i < n_samples; i++)
+    {
+      min_rss = MIN (min_rss, samples[i].rss);
+      min_objects = MIN (min_objects, samples[i].n_objects);
+    }
+
+  g_test_message ("RSS %" G_GSIZE_FORMAT " → %" G_GSIZE_FORMAT
+                  " bytes, objects %u → %u",
+                  baseline->rss, min_rss,
+                  baseline->n_objects, min_objects);
+
+  if (baseline->rss > 0)
+    g_assert_cmpuint (min_rss, <=, baseline->rss + RSS_SLACK);
+  g_assert_cmpuint (min_objects, <=, baseline->n_objects);
+}
+
+static void
+test_soak (void)
+{
+  Sample samples[N_SAMPLES];
+  GSoundContext *context;
+  GHashTable *cache_attrs;
+  const char *value;
+  guint64 n_iterations = DEFAULT_ITERATIONS;
+  guint n_batches;
+  guint n_samples = 0;
+  GSoundStats stats;
+  guint batch;
+
+  value = g_getenv ("GSOUND_SOAK_ITERATIONS");
+  if (value)
+    g_assert_true (g_ascii_string_to_unsigned (value, 10,
+                                               BATCH_SIZE * N_SAMPLES,
+                                               G_MAXUINT, &n_iterations,
+                                               NULL));
+
+  context = gsound_context_new (NULL, NULL);
+  if (!context ||
+      !gsound_context_set_driver (context, "null", NULL) ||
+      !gsound_context_open (context, NULL))
+    {
+      g_clear_object (&context);
+      g_test_skip ("libcanberra has no null driver");
+      return;
+    }
+
+  if (!g_type_get_instance_count (GSOUND_TYPE_CONTEXT))
+    g_test_message ("GOBJECT_DEBUG=instance-count is not set, so objects "
+                    "are not counted");
+
+  cache_attrs = g_hash_table_new (g_str_hash, g_str_equal);
+  g_hash_table_insert (cache_attrs, GSOUND_ATTR_EVENT_ID, "bell");
+
+  n_batches = n_iterations / BATCH_SIZE;
+
+  for (batch = 0; batch < n_batches; batch++)
+    {
+      run_batch (context, cache_attrs, batch);
+
+      if ((guint64) batch * N_SAMPLES / n_batches >= n_samples)
+        {
+          samples[n_samples].rss = get_rss ();
+          samples[n_samples].n_objects = get_n_objects ();
+          n_samples++;
+        }
+    }
+
+  g_assert_cmpuint (n_samples, ==, N_SAMPLES);
+  check_growth (samples, n_samples);
+
+  gsound_context_get_stats (context, &stats);
+  g_assert_cmpuint (stats.submitted, ==, (guint64) n_batches * BATCH_SIZE);
+  g_assert_cmpuint (stats.in_flight, ==, 0);
+
+  g_hash_table_unref (cache_attrs);
+  g_object_unref (context);
+}
+
+int
+main (int argc, char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/soak/play-cancel-cache", test_soak);
+
+  return g_test_run ();
+}
@@ -18,11 +18,19 @@
 
 string event_id;
 string filename;
+string tone;
+string waveform;
 string desc;
 string cache;
 int loops;
 double volume;
 string driver;
+[CCode (array_length = false, array_null_terminated = true)]
+string[] outputs;
+string replay;
+double speed = 1.0;
+bool preload;
+string storage;
 
 MainLoop main_loop;
 GSound.Context gs_ctx;
@@ -33,6 +41,10 @@ const OptionEntry[] opts = {
     "Event sound identifier", "STRING" },
     { "file", 'f', 0, OptionArg.FILENAME, ref filename,
     "Play file", "PATH" },
+    { "tone", 't', 0, OptionArg.STRING, ref tone,
+    "Play a synthesized tone, or a chirp between two frequencies", "HZ[:HZ]" },
+    { "waveform", 'w', 0, OptionArg.STRING, ref waveform,
+    "Tone waveform (sine, square, triangle, sawtooth)", "STRING" },
     { "description", 'd', 0, OptionArg.STRING, ref desc,
     "Event sound description", "STRING" },
     { "cache-control", 'c', 0, OptionArg.STRING, ref cache,
@@ -42,10 +54,70 @@ const OptionEntry[] opts = {
     { "volume", 'V', 0, OptionArg.DOUBLE, ref volume,
     "A floating point dB value for the sample volume (ex: 0.0)", "STRING" },
     { "backend", 'b', 0, OptionArg.STRING, ref driver,
-    "libcanberra backend to use", "STRING" },
+    "libcanberra backend to use, or a comma-separated list to race", "STRING" },
+    { "output", 'o', 0, OptionArg.STRING_ARRAY, ref outputs,
+    "Also play on this output, may be repeated", "[BACKEND][:DEVICE]" },
+    { "replay", 'r', 0, OptionArg.FILENAME, ref replay,
+    "Replay a recording made with GSOUND_RECORD", "PATH" },
+    { "speed", 's', 0, OptionArg.DOUBLE, ref speed,
+    "Replay speed, or 0 for as fast as possible (default: 1.0)", "NUMBER" },
+    { "preload", 'p', 0, OptionArg.NONE, ref preload,
+    "Decode the files given as arguments and print the time taken", null },
+    { "storage", 'S', 0, OptionArg.STRING, ref storage,
+    "How to keep preloaded files (pcm, adpcm, original)", "STRING" },
     { null }
 };
 
+void run_preload(string[] files) throws Error
+{
+    var sounds = new GenericArray<HashTable<string, string>>();
+
+    foreach (var file in files) {
+        var sound = new HashTable<string, string>(str_hash, str_equal);
+
+        sound.insert(GSound.Attribute.MEDIA_FILENAME, file);
+        sounds.add(sound);
+    }
+
+    if (storage != null) {
+        GSound.CacheStorage mode;
+
+        switch (storage) {
+        case "pcm": mode = GSound.CacheStorage.PCM; break;
+        case "adpcm": mode = GSound.CacheStorage.ADPCM; break;
+        case "original": mode = GSound.CacheStorage.ORIGINAL; break;
+        default:
+            throw new OptionError.BAD_VALUE("Unknown storage “%s”", storage);
+        }
+
+        foreach (var cache_control in new string[] { "permanent", "volatile", "never" }) {
+            gs_ctx.set_cache_storage(cache_control, mode);
+        }
+    }
+
+    var start = get_monotonic_time();
+    gs_ctx.preload(sounds);
+    var elapsed = get_monotonic_time() - start;
+
+    print("Decoded %d files in %.3f s\n", files.length, elapsed / 1000000.0);
+
+    if (storage != null) {
+        GSound.Stats stats;
+
+        /* Render every file once to measure what the storage costs */
+        start = get_monotonic_time();
+        gs_ctx.render(sounds, 48000, 2);
+        elapsed = get_monotonic_time() - start;
+
+        gs_ctx.get_stats(out stats);
+
+        print("  memory: %.1f KiB, %.1f KiB decoded\n",
+              stats.cache_size / 1024.0, stats.cache_pcm_size / 1024.0);
+        print("  rendered in %.3f s, %.3f s of it unpacking\n",
+              elapsed / 1000000.0, stats.cache_decode_time / 1000000.0);
+    }
+}
+
 async void play() throws Error
 {
     while (loops-- > 0) {
@@ -53,6 +125,24 @@ async void play() throws Error
     }
 }
 
+void run_replay() throws Error
+{
+    GSound.Stats stats;
+
+    var start = get_monotonic_time();
+    gs_ctx.replay(File.new_for_commandline_arg(replay), speed);
+    var elapsed = get_monotonic_time() - start;
+
+    gs_ctx.get_stats(out stats);
+
+    print("Replayed %s sounds in %.3f s\n",
+          stats.submitted.to_string(), elapsed / 1000000.0);
+    print("  completed: %s, failed: %s, cancelled: %s, timed out: %s\n",
+          stats.completed.to_string(), stats.failed.to_string(),
+          stats.cancelled.to_string(), stats.timed_out.to_string());
+    print("  start latency: %.3f ms\n", stats.start_latency / 1000.0);
+}
+
 int main(string[] args)
 {
     Intl.setlocale (LocaleCategory.ALL, "");
@@ -65,17 +155,45 @@ int main(string[] args)
     try {
         opt_ctx.parse(ref args);
         
-        if (event_id == null && filename == null) {
-            print("No event id or file specified.\n");
+        if (event_id == null && filename == null && tone == null &&
+            replay == null && !preload) {
+            print("No event id, file or tone specified.\n");
             return 1;
         }
         
         gs_ctx = new GSound.Context();
         gs_ctx.set_attributes(GSound.Attribute.APPLICATION_ID, "org.gnome.gsound-test");
         
-        if (driver != null) {
+        if (driver != null && driver.contains(",")) {
+            var drivers = driver.split(",");
+
+            gs_ctx.set_drivers(drivers, true);
+            foreach (var d in drivers) {
+                var latency = gs_ctx.get_open_latency(d);
+
+                if (latency >= 0) {
+                    print("Opened %s in %.3f ms\n", d, latency / 1000.0);
+                }
+            }
+        } else if (driver != null) {
             gs_ctx.set_driver(driver);
         }
+
+        foreach (var output in outputs) {
+            var parts = output.split(":", 2);
+            gs_ctx.add_output(parts[0] != "" ? parts[0] : null,
+                              parts.length > 1 ? parts[1] : null);
+        }
+
+        if (replay != null) {
+            run_replay();
+            return 0;
+        }
+
+        if (preload) {
+            run_preload(args[1:args.length]);
+            return 0;
+        }
         
         attrs = new HashTable<string, string>(str_hash, str_equal);
         
@@ -85,6 +203,17 @@ int main(string[] args)
         if (filename != null) {
             attrs.insert(GSound.Attribute.MEDIA_FILENAME, filename);
         }
+        if (tone != null) {
+            var freqs = tone.split(":", 2);
+
+            attrs.insert(GSound.Attribute.GSOUND_TONE_FREQUENCY, freqs[0]);
+            if (freqs.length > 1) {
+                attrs.insert(GSound.Attribute.GSOUND_TONE_FREQUENCY_END, freqs[1]);
+            }
+        }
+        if (waveform != null) {
+            attrs.insert(GSound.Attribute.GSOUND_TONE_WAVEFORM, waveform);
+        }
         if (cache != null) {
             attrs.insert(GSound.Attribute.CANBERRA_CACHE_CONTROL, cache);
         }